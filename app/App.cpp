@@ -6,6 +6,7 @@
 #include "tools/SequencerWindow.hpp"
 #include "tools/ChainerWindow.hpp"
 #include "tools/ScopeWindow.hpp"
+#include "tools/SpectrumWindow.hpp"
 #include "tools/VUMeterWindow.hpp"
 
 #include "instrument/SynthMachineWindow.hpp"
@@ -14,6 +15,7 @@
 #include "instrument/TB303Window.hpp"
 
 #include "../engine/core/Log.hpp"
+#include "../engine/MidiFile.hpp"
 #include "../vendor/imgui/imgui.h"
 
 
@@ -195,6 +197,10 @@ namespace sns {
 		m_windows.push_back(std::shared_ptr<ScopeWindow>(scope_window));
 		m_tools.push_back(scope_window);
 
+		SpectrumWindow* spectrum_window = new SpectrumWindow();
+		m_windows.push_back(std::shared_ptr<SpectrumWindow>(spectrum_window));
+		m_tools.push_back(spectrum_window);
+
 		VUMeterWindow* vu_meter_window = new VUMeterWindow();
 		m_windows.push_back(std::shared_ptr<VUMeterWindow>(vu_meter_window));
 		m_tools.push_back(vu_meter_window);
@@ -267,6 +273,7 @@ namespace sns {
 		}
 
 		m_configuration = sns::loadConfiguration(this);
+		engine().setDrumMachineFont(m_configuration.drum_machine_font);
 
 		for (auto& current : m_windows) {
 			current->setApp(this);
@@ -290,6 +297,8 @@ namespace sns {
 
 		Log::i(TAG, "Cleanup...");
 
+		m_midi_exporter.cancelExport();
+
 		for (auto& current : m_windows) {
 			current->shutdown();
 			current->setApp(nullptr);
@@ -323,6 +332,9 @@ namespace sns {
 
 		renderMainMenu();
 
+		// snapshots the audio thread let go of are freed here, never in the callback
+		engine().reclaim();
+
 		for (auto& current : m_windows) {
 			if (current->showing())
 				current->render();
@@ -344,6 +356,13 @@ namespace sns {
 			ImGui::GetForegroundDrawList()->AddText(pos, IM_COL32(255, 255, 255, 200), text.c_str());
 		}
 
+		if (m_midi_exporter.isExporting()) {
+			std::string const text = sfmt("Rendering %d%%", int(m_midi_exporter.progress() * 100.0f));
+			float end = width() / dpiScale();
+			ImVec2 pos(end - ImGui::GetFontSize() * 12.0f, ImGui::GetFontSize() * 0.15f);
+			ImGui::GetForegroundDrawList()->AddText(pos, IM_COL32(255, 255, 255, 200), text.c_str());
+		}
+
 
 		//
 		// compute active instrument
@@ -422,6 +441,11 @@ namespace sns {
 		}
 		m_menu[column].add("-");
 		m_menu[column].add("Toggle Recording", ImGuiKey_R, super_mod);
+		m_menu[column].add("Record Stems");
+		m_menu[column].add("Record Stem Files");
+		m_menu[column].add("-");
+		m_menu[column].add("Play MIDI File");
+		m_menu[column].add("Render MIDI File");
 
 
 		column = m_menu.size();
@@ -558,6 +582,18 @@ namespace sns {
 			else if (current == "Tools|Record") {
 				recordStart();
 			}
+			else if (current == "Tools|Record Stems") {
+				recordStart(RecordingLayout::Interleaved);
+			}
+			else if (current == "Tools|Record Stem Files") {
+				recordStart(RecordingLayout::Files);
+			}
+			else if (current == "Tools|Play MIDI File") {
+				midiPlay();
+			}
+			else if (current == "Tools|Render MIDI File") {
+				midiRender();
+			}
 			else if (current == "Tools|Stop Recording") {
 				recordStop();
 			}
@@ -744,13 +780,21 @@ namespace sns {
 		}
 	}
 
-	void App::recordStart() {
-		auto callback = [this](std::string const& filename) {
-			if (!filename.empty())
+	void App::recordStart(RecordingLayout layout) {
+		auto callback = [this, layout](std::string const& filename) {
+			if (filename.empty())
+				return;
+
+			if (layout == RecordingLayout::Mix)
 				engine().recorder().startRecording(filename);
+			else
+				engine().startStemRecording(filename, layout);
 		};
 
-		std::string filename = sfmt("%s.wav", datetimeMarker());
+		const AudioFormat format = configuration().recording_format;
+		engine().recorder().setFormat(format);
+
+		std::string filename = sfmt("%s.%s", datetimeMarker(), audioFormatExtension(format));
 		platformPickSaveFile("Audio Recording", "Please select a path where to record", filename, callback);
 	}
 
@@ -758,6 +802,42 @@ namespace sns {
 		engine().recorder().stopRecording();
 	}
 
+	void App::midiPlay() {
+		auto callback = [this](std::string const& filename) {
+			if (filename.empty())
+				return;
+
+			Timeline timeline = MidiFile::load(filename);
+			if (!timeline.empty())
+				engine().playTimeline(timeline);
+		};
+		platformPickLoadFile("Play MIDI file", "Please select the MIDI file", "mid", callback);
+	}
+
+	void App::midiRender() {
+		auto callback = [this](std::string const& filename) {
+			if (filename.empty())
+				return;
+
+			Timeline timeline = MidiFile::load(filename);
+			if (timeline.empty())
+				return;
+
+			// instruments of its own set up as the windows are, playback goes on
+			TimelineRenderer::Settings settings;
+			for (auto window : m_instruments)
+				if (window)
+					settings.values[window->subtype()] = window->values();
+			settings.drum_machine_font = configuration().drum_machine_font;
+
+			const AudioFormat format = configuration().recording_format;
+			std::string target = sfmt("%s.%s", filename, audioFormatExtension(format));
+
+			m_midi_exporter.startExport(std::move(timeline), settings, target, format);
+		};
+		platformPickLoadFile("Render MIDI file", "Please select the MIDI file", "mid", callback);
+	}
+
 
 	void App::projectClone(bool trigger) {
 		std::function<void(std::string)> callback = [this](std::string const& name) {
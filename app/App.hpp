@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../engine/Engine.hpp"
+#include "../engine/TimelineExporter.hpp"
 
 #include "Configuration.hpp"
 #include "Window.hpp"
@@ -92,9 +93,13 @@ namespace sns {
 		void projectExport();
 		void projectImport();
 
-		void recordStart();
+		void recordStart(RecordingLayout layout = RecordingLayout::Mix);
 		void recordStop();
 
+		void midiPlay();
+		void midiRender();
+		TimelineExporter m_midi_exporter;
+
 		std::string m_load_project;
 		std::string m_clone_project;
 		std::string m_import_project_file;
@@ -42,6 +42,8 @@ namespace sns {
 			//settings
 			object["settings"]["audio_buffer_size"] = configuration.audio_buffer_size;
 			object["settings"]["video_fps"] = configuration.video_fps;
+			object["settings"]["recording_format"] = toString(configuration.recording_format);
+			object["settings"]["drum_machine_font"] = configuration.drum_machine_font;
 
 			// midi
 			object["settings"]["midi"]["filter_active_instrument"] = configuration.midi.filter_active_instrument;
@@ -142,6 +144,12 @@ namespace sns {
 			if (settings.contains("video_fps"))
 				configuration.video_fps = settings["video_fps"].get<int>();
 
+			if (settings.contains("recording_format"))
+				configuration.recording_format = AudioFormat(findIndex(enumNames<AudioFormat>(), settings["recording_format"].get<std::string>(), 0));
+
+			if (settings.contains("drum_machine_font"))
+				configuration.drum_machine_font = settings["drum_machine_font"].get<std::string>();
+
 
 			loadMidi(app, configuration, settings);
 		}
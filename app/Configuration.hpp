@@ -3,6 +3,7 @@
 #include "../engine/core/Lang.hpp"
 #include "../engine/instrument/Instrument.hpp"
 #include "../engine/audio/Midi.hpp"
+#include "../engine/audio/AudioWriter.hpp"
 #include "../engine/Sequencer.hpp"
 #include "../engine/Chainer.hpp"
 
@@ -27,6 +28,10 @@ namespace sns {
 		int audio_buffer_size = 2048 / 4;
 		int video_fps = 0;
 
+		AudioFormat recording_format = AudioFormat::Float32;
+
+		std::string drum_machine_font; // user SF2 kit, empty for the embedded one
+
 		Midi::Mapping midi;
 		std::string midi_preset;
 
@@ -249,7 +249,7 @@ namespace sns {
 		json data = json::parse(in);
 		if (data.contains("duty")) cfg.duty = data["duty"].get<float>();
 		if (data.contains("tempo")) cfg.tempo = data["tempo"].get<int>();
-		if (data.contains("step_count")) cfg.step_count = data["step_count"].get<int>();
+		if (data.contains("step_count")) cfg.step_count = clampTo(data["step_count"].get<int>(), 2, Sequencer::MaxSteps);
 
 		if (data.contains("selected_instrument")) cfg.ui_selected_instrument = InstrumentId(data["selected_instrument"].get<int>());
 
@@ -269,15 +269,27 @@ namespace sns {
 				if (instument_data.contains("first_col"))
 					cfg.instruments[instrument_id].ui_first_row = instument_data["first_row"].get<int>();
 
-				if (instument_data.contains("steps")) {
-					json steps = instument_data["steps"];
+				if (instument_data.contains("selected_lane"))
+					cfg.instruments[instrument_id].ui_selected_lane = clampTo(instument_data["selected_lane"].get<int>(), 0, Sequencer::LaneCount - 1);
+
+				auto load_steps = [&cfg, instrument_id](int lane, json const& steps) {
 					for (auto const& step_data : steps) {
 						int step = step_data.contains("step") ? step_data["step"].get<int>() : 0;
 						int note = step_data.contains("note") ? step_data["note"].get<int>() : 0;
 						int value = step_data.contains("value") ? step_data["value"].get<int>() : 0;
 
-						cfg.setStepState(instrument_id, step, note, Sequencer::NoteMode(value));
+						cfg.setStepState(instrument_id, lane, step, note, Sequencer::NoteMode(value));
 					}
+				};
+
+				// the first lane keeps the original "steps" key
+				if (instument_data.contains("steps"))
+					load_steps(0, instument_data["steps"]);
+
+				if (instument_data.contains("lanes")) {
+					json lanes = instument_data["lanes"];
+					for (int lane = 1; lane < Sequencer::LaneCount && lane <= int(lanes.size()); ++lane)
+						load_steps(lane, lanes[lane - 1]);
 				}
 			}
 		}
@@ -300,20 +312,29 @@ namespace sns {
 			for (int instrument_id = InstrumentStart; instrument_id != cfg.instruments.size(); ++instrument_id) {
 				std::string instrument_name = instrumentToString(InstrumentId(instrument_id));
 
-				json array = json::array();
+				auto save_steps = [](Sequencer::InstrumentConfiguration::Steps const& steps) -> json {
+					json array = json::array();
 
-				for (auto const& [key, value] : cfg.instruments[instrument_id].steps) {
-					auto [step, note] = key;
+					steps.each([&array](int step, int note, Sequencer::NoteMode value) {
+						json data;
+						data["step"] = step;
+						data["note"] = note;
+						data["value"] = value;
 
-					json data;
-					data["step"] = step;
-					data["note"] = note;
-					data["value"] = value;
+						array.push_back(data);
+					});
 
-					array.push_back(data);
-				}
+					return array;
+				};
+
+				auto const& lanes = cfg.instruments[instrument_id].lanes;
+				root[instrument_name]["steps"] = save_steps(lanes[0]);
 
-				root[instrument_name]["steps"] = array;
+				json extra_lanes = json::array();
+				for (int lane = 1; lane != Sequencer::LaneCount; ++lane)
+					extra_lanes.push_back(save_steps(lanes[lane]));
+				root[instrument_name]["lanes"] = extra_lanes;
+				root[instrument_name]["selected_lane"] = cfg.instruments[instrument_id].ui_selected_lane;
 				root[instrument_name]["muted"] = cfg.instruments[instrument_id].muted;
 
 				root[instrument_name]["first_col"] = cfg.instruments[instrument_id].ui_first_col;
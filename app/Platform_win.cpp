@@ -28,6 +28,9 @@ namespace sns {
 		if (ext == "wav")
 			return "Wav file (*.wav)";
 
+		if (ext == "flac")
+			return "Flac file (*.flac)";
+
 		return ext;
 	}
 
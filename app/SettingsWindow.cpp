@@ -58,6 +58,15 @@ namespace sns {
 		ImGui::SameLine();
 		pHelpMarker("Amount of samples produced and buffered per step. Requires a restart.");
 
+		static const std::vector<std::string> formats = enumNames<AudioFormat>();
+		int format = int(configuration.recording_format);
+		if (pCombo("Recording", formats, format)) {
+			configuration.recording_format = AudioFormat(format);
+			saveConfiguration(app(), configuration);
+		}
+		ImGui::SameLine();
+		pHelpMarker("File format of recordings. 16/24 bit are dithered, FLAC is lossless and about half the size.");
+
 		ImGui::Unindent();
 	}
 
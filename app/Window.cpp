@@ -203,6 +203,10 @@ namespace sns {
 		m_values = values;
 	}
 
+	ParametersValues const& Window::values() const {
+		return m_values;
+	}
+
 	void Window::savePreset(std::string const& name) {
 		Log::d(TAG, sfmt("savePreset %s", name));
 		onSavePreset(name);
@@ -41,6 +41,7 @@ namespace sns {
 		void loadFrom(nlohmann::json& json);
 
 		void setValues(ParametersValues values);
+		ParametersValues const& values() const;
 
 
 		static void uiNamePicker(bool trigger,
@@ -1,6 +1,7 @@
 #include "DrumMachineWindow.hpp"
 
 #include "../App.hpp"
+#include "../Platform.hpp"
 #include "../vendor/imgui/imgui.h"
 #include "../vendor/imgui-knobs/imgui-knobs.h"
 #include "../../engine/core/Text.hpp"
@@ -91,6 +92,32 @@ namespace sns {
 	void DrumMachineWindow::renderOptions() {
 		ImGui::TextDisabled("OPTIONS");
 		pKnob("Volume", ParameterVolume);
+
+		ImGui::Spacing();
+		ImGui::TextDisabled("KIT");
+
+		const float width = ImGui::GetContentRegionAvail().x;
+		if (ImGui::Button("SF2...", ImVec2(width, 0)))
+			pickFont();
+
+		if (!app()->configuration().drum_machine_font.empty() && ImGui::Button("Default", ImVec2(width, 0)))
+			setFont("");
+	}
+
+	void DrumMachineWindow::pickFont() {
+		auto callback = [this](std::string const& filename) {
+			if (!filename.empty())
+				setFont(filename);
+		};
+		platformPickLoadFile("Drum Machine kit", "Please select the SF2 sound font", "sf2", callback);
+	}
+
+	void DrumMachineWindow::setFont(std::string const& filename) {
+		Configuration& configuration = app()->configuration();
+		configuration.drum_machine_font = filename;
+		saveConfiguration(app(), configuration);
+
+		app()->engine().setDrumMachineFont(filename);
 	}
 
 }
\ No newline at end of file
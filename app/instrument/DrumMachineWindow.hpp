@@ -17,5 +17,9 @@ namespace sns {
 
 		void renderTable(std::string const& name, std::vector<DrumMachine::DMKey> const& data);
 		void renderOptions();
+
+		// the kit is a setting, a user SF2 or the embedded one for an empty filename
+		void pickFont();
+		void setFont(std::string const& filename);
 	};
 }
\ No newline at end of file
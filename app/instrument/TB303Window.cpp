@@ -73,6 +73,22 @@ namespace sns {
 			m_values[ParameterOscBase + ParameterOscKind] = float(osc_kind);
 			applyInstrumentValues();
 		}
+
+		ImGui::SameLine();
+		ImGui::TextDisabled("Quality");
+		ImGui::SameLine();
+
+		int quality = int(m_values[ParameterQuality]);
+		changed = false;
+		changed |= ImGui::RadioButton("1x", &quality, TB303QualityLow);
+		ImGui::SameLine();
+		changed |= ImGui::RadioButton("2x", &quality, TB303QualityMedium);
+		ImGui::SameLine();
+		changed |= ImGui::RadioButton("4x", &quality, TB303QualityHigh);
+		if (changed) {
+			m_values[ParameterQuality] = float(quality);
+			applyInstrumentValues();
+		}
 	}
 
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "../App.hpp"
 
 #include "../engine/core/Log.hpp"
+#include "../engine/MidiFile.hpp"
 
 #include "../vendor/imgui/imgui.h"
 #include "../vendor/imgui-fonts/material_design_icons.h" 
@@ -17,6 +18,7 @@ namespace sns {
 		m_window_name = "Chainer";
 
 		m_selected = 0;
+		m_start_step = 1;
 		m_cfg_loaded = false;
 
 		m_has_presets = true;
@@ -54,6 +56,7 @@ namespace sns {
 		if (m_cfg.action != Sequencer::Action::None) {
 			if (m_cfg.action == Sequencer::Action::Play) {
 				m_cfg.action_link = m_selected;
+				m_cfg.action_step = m_start_step - 1;
 				inflate(app()->configuration(), m_cfg);
 			}
 			else {
@@ -93,13 +96,19 @@ namespace sns {
 
 			if (blink)
 				ImGui::PopStyleColor();
+
+			// step of the selected link playback starts from
+			ImGui::SameLine();
+			ImGui::SetNextItemWidth(ImGui::GetTextLineHeight() * 2.0f);
+			ImGui::DragInt("##start_step", &m_start_step, 0.25f, 1, Sequencer::MaxSteps);
 		}
 
 		float const spacing = ImGui::GetTextLineHeight() * 5.25f;
-		ImGui::SameLine(0.0f, spacing);
+		ImGui::SameLine(0.0f, spacing - ImGui::GetTextLineHeight() * 2.0f);
 		int index = m_state.playing ? m_state.link_index + 1 : 0;
 		int run = m_state.playing ? m_state.link_run + 1 : 0;
-		ImGui::Text("%03d/%03d", index, run);
+		int step = m_state.playing ? m_state.step + 1 : 0;
+		ImGui::Text("%03d/%03d/%03d", index, run, step);
 		ImGui::SameLine(0.0f, spacing);
 
 		// line action
@@ -157,9 +166,25 @@ namespace sns {
 					m_selected = clampTo(m_selected, 0, int(m_cfg.chain.size()) - 1);
 				}
 			}
+
+			ImGui::SameLine();
+
+			if (ImGui::Button((const char*)ICON_MDI_FILE_MUSIC))
+				exportMidi();
 		}
 	}
 
+	void ChainerWindow::exportMidi() {
+		Chainer::Configuration cfg = m_cfg;
+		inflate(app()->configuration(), cfg);
+
+		auto callback = [cfg](std::string const& filename) {
+			if (!filename.empty())
+				MidiFile::save(filename, cfg);
+		};
+		platformPickSaveFile("Export MIDI", "Please select a path where to export the chain", sfmt("chain_-_%s.mid", datetimeMarker()), callback);
+	}
+
 	void ChainerWindow::renderTable(float height) {
 
 		float const base_width = ImGui::GetTextLineHeight();
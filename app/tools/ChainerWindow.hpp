@@ -23,6 +23,7 @@ namespace sns {
 
 		void renderTopBar();
 		void renderTable(float height);
+		void exportMidi();
 
 		void onSavePreset(std::string const& name) override;
 		void onLoadPreset(std::string const& name) override;
@@ -30,6 +31,7 @@ namespace sns {
 		void onRefreshPresets() override;
 
 		int m_selected;
+		int m_start_step;
 		Chainer::Configuration m_cfg;
 		bool m_cfg_loaded;
 		Chainer::State m_state;
@@ -86,11 +86,12 @@ namespace sns {
 		{
 			uint64_t produced_ms;
 			float syntesis_average_ms;
+			float syntesis_peak_ms;
 			int filled_samples;
-			app()->engine().stats(syntesis_average_ms, produced_ms, filled_samples);
+			app()->engine().stats(syntesis_average_ms, syntesis_peak_ms, produced_ms, filled_samples);
 
-			ImGui::Text("Audio [Synthesis: %.1fms, Packet: %dms, Generated: %s]",
-				syntesis_average_ms, int(audioMilliseconds(filled_samples)), timecode(produced_ms).c_str());
+			ImGui::Text("Audio [Synthesis: %.1fms (p99 %.1fms), Packet: %dms, Generated: %s]",
+				syntesis_average_ms, syntesis_peak_ms, int(audioMilliseconds(filled_samples)), timecode(produced_ms).c_str());
 		}
 
 		auto keyboard = app()->getWindow<KeyboardWindow>();
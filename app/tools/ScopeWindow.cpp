@@ -3,7 +3,6 @@
 #include "../App.hpp"
 #include "../engine/core/Log.hpp"
 #include "../vendor/imgui/imgui.h"
-#include "../tools/VUMeterWindow.hpp"
 
 
 namespace sns {
@@ -16,9 +15,9 @@ namespace sns {
 		m_active = true;
 		m_offset_factor = 0.0f;
 
-		m_time_values = {1, 2, 5, 10, 20, 25, 50, 100, 150, 200};
+		m_time_values = {1, 2, 5, 10, 20, 25, 50, 100, 150, 200, 500, 1000, 5000, 10000, 30000, 60000, 5 * 60000};
 		for (auto current : m_time_values)
-			m_time_names.push_back(sfmt("%d ms", current));
+			m_time_names.push_back(current >= 60000 ? sfmt("%d min", current / 60000) : (current >= 1000 ? sfmt("%d s", current / 1000) : sfmt("%d ms", current)));
 		m_time = 3;
 
 
@@ -46,16 +45,13 @@ namespace sns {
 
 		ImGui::Begin(m_window_name.c_str(), &m_showing, ImGuiWindowFlags_NoResize);
 
-		if (m_showing && !analyser.isAccepting() && m_active)
+		if (m_showing && !analyser.isStartedBy(TAG) && m_active)
 			updateCapture();
 
 		float base_size = ImGui::GetTextLineHeightWithSpacing() * 2.0f;
 
-		app()->engine().analyser().generateGraph(m_samples);
-
-		ImGui::PlotLines("##Lines", m_samples.data(), int(m_samples.size()), 0, 
-			"", -1.0f, 1.0f, 
-			ImVec2(base_size * 10.0f, base_size * 5.0f));
+		analyser.generateGraph(m_minimums, m_maximums);
+		renderGraph(base_size * 10.0f, base_size * 5.0f);
 
 		ImGui::SameLine();
 
@@ -64,16 +60,7 @@ namespace sns {
 		//
 		ImGui::BeginChild("options_block", ImVec2(base_size * 4.0f, 0), true);
 		{
-			bool running_disabled = app()->getWindow<VUMeterWindow>()->showing();
-			
-			if (running_disabled) 
-				ImGui::BeginDisabled(true);
 			ImGui::Checkbox("Running", &m_active);
-			if (running_disabled) {
-				ImGui::EndDisabled();
-				ImGui::SameLine();
-				pHelpMarker("Disabled while VU Meter opened");
-			}
 
 			if (pCombo("Time", m_time_names, m_time))
 				updateCapture();
@@ -98,7 +85,7 @@ namespace sns {
 
 
 
-		if (analyser.isAccepting() && (!m_showing || !m_active)) {
+		if (analyser.isStartedBy(TAG) && (!m_showing || !m_active)) {
 			analyser.stop(TAG);
 		}
 
@@ -106,6 +93,41 @@ namespace sns {
 		ImGui::End();
 	}
 
+	void ScopeWindow::renderGraph(float width, float height) {
+		const ImVec2 size(width, height);
+		ImDrawList* draw_list = ImGui::GetWindowDrawList();
+		ImVec2 origin = ImGui::GetCursorScreenPos();
+		ImGuiStyle const& style = ImGui::GetStyle();
+
+		draw_list->AddRectFilled(origin, ImVec2(origin.x + size.x, origin.y + size.y), ImGui::GetColorU32(ImGuiCol_FrameBg), style.FrameRounding);
+		ImGui::Dummy(size);
+
+		const int count = int(m_minimums.size());
+		if (count < 2)
+			return;
+
+		const ImU32 color = ImGui::GetColorU32(ImGuiCol_PlotLines);
+		const float half_height = (size.y - 2.0f * style.FramePadding.y) * 0.5f;
+		const float center = origin.y + size.y * 0.5f;
+		const float step = (size.x - 2.0f * style.FramePadding.x) / float(count - 1);
+
+		auto y = [center, half_height](float value) { return center - clampTo(value, -1.0f, 1.0f) * half_height; };
+
+		// a line through the envelope centers plus the envelope itself where a point covers many samples
+		for (int i = 0; i != count; ++i) {
+			const float x = origin.x + style.FramePadding.x + float(i) * step;
+
+			if (m_maximums[i] > m_minimums[i])
+				draw_list->AddLine(ImVec2(x, y(m_maximums[i])), ImVec2(x, y(m_minimums[i]) + 1.0f), color);
+
+			if (i > 0) {
+				const float previous = (m_minimums[i - 1] + m_maximums[i - 1]) * 0.5f;
+				const float current = (m_minimums[i] + m_maximums[i]) * 0.5f;
+				draw_list->AddLine(ImVec2(x - step, y(previous)), ImVec2(x, y(current)), color);
+			}
+		}
+	}
+
 	void ScopeWindow::updateCapture() {
 		Analyser& analyser = app()->engine().analyser();
 
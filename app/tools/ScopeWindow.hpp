@@ -13,9 +13,11 @@ namespace sns
 		void render() override;
 
 	private:
-		std::vector<float> m_samples;
+		std::vector<float> m_minimums;
+		std::vector<float> m_maximums;
 
 		void updateCapture();
+		void renderGraph(float width, float height);
 
 		// pickers
 		bool m_active;
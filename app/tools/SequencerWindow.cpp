@@ -4,6 +4,7 @@
 #include "../App.hpp"
 
 #include "../engine/core/Log.hpp"
+#include "../engine/MidiFile.hpp"
 
 #include "../vendor/imgui/imgui.h"
 #include "../vendor/imgui/imgui_internal.h"
@@ -137,6 +138,19 @@ namespace sns {
 		return output;
 	}
 
+	static std::vector<std::string> laneNames() {
+		std::vector<std::string> output;
+
+		for (int i = 0; i != Sequencer::LaneCount; i++)
+			output.push_back(sfmt("Lane %d", i + 1));
+
+		return output;
+	}
+
+	int SequencerWindow::selectedLane() const {
+		return clampTo(m_cfg.instruments[m_cfg.ui_selected_instrument].ui_selected_lane, 0, Sequencer::LaneCount - 1);
+	}
+
 	void SequencerWindow::renderTopBar() {
 		// leading icons
 		{
@@ -187,15 +201,40 @@ namespace sns {
 			}
 		}
 
-		// Clear instrument
+		// lane
+		{
+			ImGui::SameLine();
+			ImGui::SetNextItemWidth(item_width * 1.6f);
+
+			static std::vector<std::string> lane_names = laneNames();
+			int& lane = m_cfg.instruments[m_cfg.ui_selected_instrument].ui_selected_lane;
+			int index = clampTo(lane, 0, Sequencer::LaneCount - 1);
+			pCombo("##lane", lane_names, index);
+			if (index != lane)
+				lane = index;
+		}
+
+		// Clear instrument lane
 		{
 			ImGui::SameLine();
 			if (ImGui::Button((const char*)ICON_MDI_DELETE)) {
-				m_cfg.instruments[m_cfg.ui_selected_instrument].steps.clear();
+				m_cfg.instruments[m_cfg.ui_selected_instrument].lanes[selectedLane()].clear();
 				m_cfg_updated = true;
 			}
 		}
 
+		// export
+		{
+			ImGui::SameLine();
+			if (ImGui::Button((const char*)ICON_MDI_FILE_MUSIC)) {
+				auto callback = [cfg = m_cfg](std::string const& filename) {
+					if (!filename.empty())
+						MidiFile::save(filename, cfg);
+				};
+				platformPickSaveFile("Export MIDI", "Please select a path where to export the sequence", sfmt("sequence_-_%s.mid", datetimeMarker()), callback);
+			}
+		}
+
 		// duty
 		{
 			ImGui::SameLine(0.0f, ImGui::GetTextLineHeight() * 1.3f);
@@ -248,7 +287,7 @@ namespace sns {
 				m_cfg_updated = true;
 			}
 			ImGui::PopButtonRepeat();
-			m_cfg.step_count = clampTo(m_cfg.step_count, 2, 64);
+			m_cfg.step_count = clampTo(m_cfg.step_count, 2, Sequencer::MaxSteps);
 		}
 
 	}
@@ -348,9 +387,9 @@ namespace sns {
 					ImGui::PushID(note * 1000 + step_index);
 					ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, ImVec2(0.0f, 0.0f));
 					ImGui::PushStyleColor(ImGuiCol_Button, ImVec4(0.0f, 0.0f, 0.0f, 0.0f));
-					Sequencer::NoteMode value = m_cfg.stepState(m_cfg.ui_selected_instrument, step_index, note);
+					Sequencer::NoteMode value = m_cfg.stepState(m_cfg.ui_selected_instrument, selectedLane(), step_index, note);
 					if (ImGui::Button(sfmt("%s###btn", m_note_icons[int(value)]).c_str(), button_size)) {
-						m_cfg.toggleStepState(m_cfg.ui_selected_instrument, step_index, note);
+						m_cfg.toggleStepState(m_cfg.ui_selected_instrument, selectedLane(), step_index, note);
 						m_cfg_updated = true;
 					}
 
@@ -395,7 +434,7 @@ namespace sns {
 				Sequencer::NoteMode mode = Sequencer::NoteMode(mode_i);
 				ImGuiKey key = ImGuiKey(m_note_keys[mode_i]);
 				if (ImGui::IsKeyDown(key) && value != mode) {
-					m_cfg.setStepState(m_cfg.ui_selected_instrument, step_index, note, mode);
+					m_cfg.setStepState(m_cfg.ui_selected_instrument, selectedLane(), step_index, note, mode);
 					m_cfg_updated = true;
 				}
 			}
@@ -422,7 +461,7 @@ namespace sns {
 			for (int mode_i = int(Sequencer::NoteMode::Off); mode_i != int(Sequencer::NoteMode::Count); ++mode_i) {
 				Sequencer::NoteMode mode = Sequencer::NoteMode(mode_i);
 				if (ImGui::Selectable(sfmt("%s %s", m_note_icons[mode_i], toString(mode)).c_str())) {
-					m_cfg.setStepState(m_cfg.ui_selected_instrument, step_index, note, mode);
+					m_cfg.setStepState(m_cfg.ui_selected_instrument, selectedLane(), step_index, note, mode);
 					m_cfg_updated = true;
 				}
 			}
@@ -447,36 +486,36 @@ namespace sns {
 		if (kind == MoveKind::Down) {
 			for (int current_step = step_index; current_step != m_cfg.step_count; current_step++) {
 				for (int current_note = 1; current_note <= note; current_note++) {
-					Sequencer::NoteMode mode = m_cfg.stepState(m_cfg.ui_selected_instrument, current_step, current_note);
-					m_cfg.setStepState(m_cfg.ui_selected_instrument, current_step, current_note - 1, mode);
+					Sequencer::NoteMode mode = m_cfg.stepState(m_cfg.ui_selected_instrument, selectedLane(), current_step, current_note);
+					m_cfg.setStepState(m_cfg.ui_selected_instrument, selectedLane(), current_step, current_note - 1, mode);
 				}
-				m_cfg.setStepState(m_cfg.ui_selected_instrument, current_step, note, Sequencer::NoteMode::Off);
+				m_cfg.setStepState(m_cfg.ui_selected_instrument, selectedLane(), current_step, note, Sequencer::NoteMode::Off);
 			}
 		} else if (kind == MoveKind::Up) {
 			for (int current_step = step_index; current_step != m_cfg.step_count; current_step++) {
 				for (int current_note = note; current_note > 0; current_note--) {
 					if (current_note == (TotalNotes - 1)) continue;
-					Sequencer::NoteMode mode = m_cfg.stepState(m_cfg.ui_selected_instrument, current_step, current_note);
-					m_cfg.setStepState(m_cfg.ui_selected_instrument, current_step, current_note + 1, mode);
+					Sequencer::NoteMode mode = m_cfg.stepState(m_cfg.ui_selected_instrument, selectedLane(), current_step, current_note);
+					m_cfg.setStepState(m_cfg.ui_selected_instrument, selectedLane(), current_step, current_note + 1, mode);
 				}
-				m_cfg.setStepState(m_cfg.ui_selected_instrument, current_step, 0, Sequencer::NoteMode::Off);
+				m_cfg.setStepState(m_cfg.ui_selected_instrument, selectedLane(), current_step, 0, Sequencer::NoteMode::Off);
 			}
 		} else if (kind == MoveKind::Left) {
 			for (int current_note = 0; current_note <= note; current_note++) {
 				for (int current_step = step_index; current_step != m_cfg.step_count; current_step++) {
 					if (current_step == 0) continue;
-					Sequencer::NoteMode mode = m_cfg.stepState(m_cfg.ui_selected_instrument, current_step, current_note);
-					m_cfg.setStepState(m_cfg.ui_selected_instrument, current_step - 1, current_note, mode);
+					Sequencer::NoteMode mode = m_cfg.stepState(m_cfg.ui_selected_instrument, selectedLane(), current_step, current_note);
+					m_cfg.setStepState(m_cfg.ui_selected_instrument, selectedLane(), current_step - 1, current_note, mode);
 				}
-				m_cfg.setStepState(m_cfg.ui_selected_instrument, m_cfg.step_count - 1, current_note, Sequencer::NoteMode::Off);
+				m_cfg.setStepState(m_cfg.ui_selected_instrument, selectedLane(), m_cfg.step_count - 1, current_note, Sequencer::NoteMode::Off);
 			}
 		} else if (kind == MoveKind::Right) {
 			for (int current_note = 0; current_note <= note; current_note++) {
 				for (int current_step = (m_cfg.step_count - 2); current_step >= step_index; current_step--){
-					Sequencer::NoteMode mode = m_cfg.stepState(m_cfg.ui_selected_instrument, current_step, current_note);
-					m_cfg.setStepState(m_cfg.ui_selected_instrument, current_step + 1, current_note, mode);
+					Sequencer::NoteMode mode = m_cfg.stepState(m_cfg.ui_selected_instrument, selectedLane(), current_step, current_note);
+					m_cfg.setStepState(m_cfg.ui_selected_instrument, selectedLane(), current_step + 1, current_note, mode);
 				}
-				m_cfg.setStepState(m_cfg.ui_selected_instrument, step_index, current_note, Sequencer::NoteMode::Off);
+				m_cfg.setStepState(m_cfg.ui_selected_instrument, selectedLane(), step_index, current_note, Sequencer::NoteMode::Off);
 			}
 		}
 	}
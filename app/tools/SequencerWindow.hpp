@@ -19,6 +19,7 @@ namespace sns {
 		void renderTopBar();
 		void renderTable(float height);
 		void renderPopup(int step_index, int note);
+		int selectedLane() const;
 
 		void onSavePreset(std::string const& name) override;
 		void onLoadPreset(std::string const& name) override;
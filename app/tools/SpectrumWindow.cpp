@@ -0,0 +1,128 @@
+#include "SpectrumWindow.hpp"
+
+#include "../App.hpp"
+#include "../engine/core/Log.hpp"
+#include "../vendor/imgui/imgui.h"
+
+
+namespace sns {
+
+	constexpr float SpectrumMinDb = -96.0f;
+
+	SpectrumWindow::SpectrumWindow()
+	{
+		TAG = "Spectrum";
+		m_window_name = "Spectrum";
+
+		m_active = true;
+		m_bins = 0;
+		m_smoothing = 0.7f;
+
+		m_size_values = { 1024, 2048, 4096, 8192, 16384 };
+		for (auto current : m_size_values)
+			m_size_names.push_back(sfmt("%d", current));
+		m_size = 2;
+
+		m_window_values = { FftWindow::Rectangular, FftWindow::Hann, FftWindow::BlackmanHarris };
+		for (auto current : m_window_values)
+			m_window_names.push_back(toString(current));
+		m_window = 1;
+
+		m_overlap_values = { 0.0f, 0.5f, 0.75f, 0.875f };
+		for (auto current : m_overlap_values)
+			m_overlap_names.push_back(sfmt("%d%%", int(current * 100.0f)));
+		m_overlap = 1;
+	}
+
+	SpectrumWindow::~SpectrumWindow() {
+
+	}
+
+	void SpectrumWindow::render() {
+		beforeRender();
+
+		Spectrum& spectrum = app()->engine().spectrum();
+
+		ImGui::Begin(m_window_name.c_str(), &m_showing, ImGuiWindowFlags_NoResize);
+
+		float base_size = ImGui::GetTextLineHeightWithSpacing() * 2.0f;
+		ImVec2 plot_size(base_size * 14.0f, base_size * 5.0f);
+
+		// one bin per horizontal pixel, the binning is precomputed by the engine
+		int bins = int(plot_size.x);
+		if (bins != m_bins) {
+			m_bins = bins;
+			updateCapture();
+		}
+		else if (m_showing && !spectrum.isRunning() && m_active) {
+			updateCapture();
+		}
+
+		spectrum.levels(m_levels, m_frequencies);
+
+		ImGui::BeginGroup();
+		{
+			ImGui::PlotLines("##Spectrum", m_levels.data(), int(m_levels.size()), 0,
+				"", SpectrumMinDb, 0.0f, plot_size);
+
+			// frequency labels under the plot
+			if (!m_frequencies.empty()) {
+				ImVec2 start = ImGui::GetCursorPos();
+				for (float hz : { 100.0f, 1000.0f, 10000.0f }) {
+					auto found = std::lower_bound(m_frequencies.begin(), m_frequencies.end(), hz);
+					if (found == m_frequencies.end())
+						continue;
+
+					float x = plot_size.x * float(found - m_frequencies.begin()) / float(m_frequencies.size());
+					ImGui::SetCursorPos(ImVec2(start.x + x, start.y));
+					ImGui::TextDisabled(hz >= 1000.0f ? "%.0fk" : "%.0f", hz >= 1000.0f ? hz / 1000.0f : hz);
+				}
+			}
+		}
+		ImGui::EndGroup();
+
+		ImGui::SameLine();
+
+		//
+		// Pickers
+		//
+		ImGui::BeginChild("options_block", ImVec2(base_size * 4.5f, 0), true);
+		{
+			ImGui::Checkbox("Running", &m_active);
+
+			if (pCombo("Size", m_size_names, m_size))
+				updateCapture();
+
+			if (pCombo("Window", m_window_names, m_window))
+				updateCapture();
+
+			if (pCombo("Overlap", m_overlap_names, m_overlap))
+				updateCapture();
+
+			if (ImGui::SliderFloat("Smooth", &m_smoothing, 0.0f, 0.95f, "%.2f"))
+				updateCapture();
+		}
+		ImGui::EndChild();
+
+		if (spectrum.isRunning() && (!m_showing || !m_active))
+			spectrum.stop(TAG);
+
+		aboutToFinishRender();
+		ImGui::End();
+	}
+
+	void SpectrumWindow::updateCapture() {
+		Spectrum& spectrum = app()->engine().spectrum();
+
+		Spectrum::Configuration cfg;
+		cfg.fft_size = m_size_values[m_size];
+		cfg.window = m_window_values[m_window];
+		cfg.overlap = m_overlap_values[m_overlap];
+		cfg.smoothing = m_smoothing;
+		cfg.bins = clampAbove(m_bins, 2);
+		spectrum.configure(cfg);
+
+		if (m_showing && m_active)
+			spectrum.start(TAG);
+	}
+}
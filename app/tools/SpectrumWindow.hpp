@@ -0,0 +1,39 @@
+#pragma once
+
+#include "../Window.hpp"
+
+namespace sns
+{
+	class SpectrumWindow : public Window
+	{
+	public:
+		SpectrumWindow();
+		~SpectrumWindow() override;
+
+		void render() override;
+
+	private:
+		std::vector<float> m_levels;
+		std::vector<float> m_frequencies;
+
+		void updateCapture();
+
+		// pickers
+		bool m_active;
+		int m_bins;
+
+		std::vector<std::string> m_size_names;
+		std::vector<int> m_size_values;
+		int m_size;
+
+		std::vector<std::string> m_window_names;
+		std::vector<FftWindow> m_window_values;
+		int m_window;
+
+		std::vector<std::string> m_overlap_names;
+		std::vector<float> m_overlap_values;
+		int m_overlap;
+
+		float m_smoothing;
+	};
+}
@@ -20,14 +20,13 @@ namespace sns {
 	void VUMeterWindow::render(){
 		beforeRender();
 
-		Analyser& analyser = app()->engine().analyser();
+		LoudnessMeter& loudness = app()->engine().loudness();
 	
 		ImGui::Begin("VU", &m_showing, ImGuiWindowFlags_NoResize);
 
-        if (m_showing && !analyser.isAccepting())
-			analyser.start(TAG);
-
-		const float current_linear = analyser.peak();
+		// computed incrementally by the engine, nothing to scan here
+		const LoudnessLevels levels = loudness.levels();
+		const float current_linear = levels.peak;
 		const float current_db = toDb(current_linear);
 		const std::string text = sfmt("%05.1f db", current_db);
 
@@ -81,11 +80,24 @@ namespace sns {
 		}
 		ImGui::EndChild();
 
+		auto lufs = [](float value) { return std::isfinite(value) ? sfmt("%05.1f", value) : std::string("  -.-"); };
 
-
-		if (!m_showing && analyser.isAccepting())
-			analyser.stop(TAG);
+		ImGui::TextDisabled("TP");
+		ImGui::SameLine();
+		ImGui::Text("%05.1f db", toDb(levels.true_peak));
+		ImGui::TextDisabled("M ");
+		ImGui::SameLine();
+		ImGui::Text("%s LUFS", lufs(levels.momentary).c_str());
+		ImGui::TextDisabled("S ");
+		ImGui::SameLine();
+		ImGui::Text("%s LUFS", lufs(levels.short_term).c_str());
+		ImGui::TextDisabled("I ");
+		ImGui::SameLine();
+		ImGui::Text("%s LUFS", lufs(levels.integrated).c_str());
+		if (ImGui::Button("Reset"))
+			loudness.reset();
 		
+
 		aboutToFinishRender();
 		ImGui::End();
 	}
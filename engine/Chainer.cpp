@@ -1,14 +1,27 @@
 #include "Chainer.hpp"
 #include "core/Log.hpp"
 #include "Engine.hpp"
+#include "Timeline.hpp"
+
+#include <limits>
 
 namespace sns {
 
 	Chainer::Chainer()
 		:TAG("Chainer"),
-		m_engine(nullptr)
+		m_engine(nullptr),
+		m_action(Sequencer::Action::None),
+		m_position(0),
+		m_next_event(0),
+		m_next_position(0),
+		m_sounding{}
 	{
-		apply(Configuration());
+		Sequencer::Configuration stop;
+		stop.action = Sequencer::Action::Stop;
+		m_stop_sequence = std::make_shared<Sequencer::Configuration const>(stop);
+
+		auto cfg = prepare(Configuration());
+		apply(cfg, std::make_shared<Timeline const>(Timeline::compile(*cfg)));
 		panic();
 	}
 
@@ -20,137 +33,182 @@ namespace sns {
 		return m_state;
 	}
 
-	bool Chainer::advanceToNext() {
-		if (!m_cfg.valid)
-			return false;
-
-		if (m_state.link_run < (m_cfg.chain[m_state.link_index].runs - 1)) {
-			m_state.link_run++;
-			return false;
-		}
+	Snapshot<Chainer::Configuration> Chainer::prepare(Configuration const& source) {
+		auto cfg = std::make_shared<Configuration>(source);
+		cfg->valid = false;
 
-		// move to next link
-		int current = m_state.link_index;
+		for (auto& chain : cfg->chain) {
+			chain.valid = false;
 
-		m_state.link_index = (m_state.link_index + 1) % m_cfg.chain.size();
-		m_state.link_run = 0;
+			if (chain.name.empty() || chain.runs <= 0)
+				continue;
 
-		while (!m_cfg.chain[m_state.link_index].valid)
-			m_state.link_index = (m_state.link_index + 1) % m_cfg.chain.size();
+			for (InstrumentId instrument = InstrumentStart; instrument != InstrumentCount; ++instrument) {
+				auto const& idata = chain.sequence.instruments[instrument];
+				if (idata.muted) continue;
 
-		bool looped = m_state.link_index < current;
+				chain.valid = true;
+				cfg->valid = true;
+				break;
+			}
+		}
 
-		return looped;
+		return cfg;
 	}
 
-	void Chainer::apply(Configuration const& cfg) {
-		if (cfg.action != Sequencer::Action::None)
-			Log::i(TAG, sfmt("Chainer::action=%s", toString(cfg.action)));
+	void Chainer::apply(Snapshot<Configuration> cfg, Snapshot<Timeline> timeline) {
+		if (cfg->action != Sequencer::Action::None)
+			Log::i(TAG, sfmt("Chainer::action=%s", toString(cfg->action)));
+
+		if (cfg->action == Sequencer::Action::Stop || cfg->action == Sequencer::Action::Pause)
+			m_engine->sequencer().apply(m_stop_sequence, true);
+
+		// the notes of the timeline being replaced
+		releaseSounding();
 
-		if (cfg.action == Sequencer::Action::Stop || cfg.action == Sequencer::Action::Pause) {
-			Sequencer::Configuration sequence;
-			sequence.action = Sequencer::Action::Stop;
-			m_engine->sequencer().apply(sequence, true);
+		if (m_engine) {
+			m_engine->reclaimer().retire(std::move(m_cfg));
+			m_engine->reclaimer().retire(std::move(m_timeline));
 		}
 
-		m_cfg = cfg;
-		m_cfg.valid = false;
+		m_cfg = std::move(cfg);
+		m_timeline = std::move(timeline);
+		m_action = m_cfg->action;
 		m_state.playing = false;
+	}
 
-		for (auto& chain : m_cfg.chain) {
-			chain.valid = false;
+	void Chainer::start(int link, int step) {
+		auto const& positions = m_timeline->positions();
 
-			if (chain.name.empty() || chain.runs <= 0)
-				continue;
+		// from the requested step, or the start of the next valid link
+		size_t index = positions.size();
+		for (int i = 0; i != int(m_cfg->chain.size()) && index == positions.size(); ++i)
+			index = m_timeline->find((link + i) % int(m_cfg->chain.size()), (i == 0) ? step : 0);
 
-			for (InstrumentId instrument = InstrumentStart; instrument != InstrumentCount; ++instrument) {
-				auto const& idata = chain.sequence.instruments[instrument];
-				if (idata.muted) continue;
+		if (index == positions.size())
+			return;
 
-				chain.valid = true;
-				m_cfg.valid = true;
-
-				// for (auto const& [step_note, note_mode] : idata.steps) {
-				// 	auto [step, note] = step_note;
-				// 	if (note_mode == Sequencer::NoteMode::Off)
-				// 		continue;
-				// 	if (step >= chain.sequence.step_count)
-				// 		continue;
-
-				// 	chain.valid = true;
-				// 	m_cfg.valid = true;
-				// 	break;
-				// }
-
-				if (chain.valid)
-					break;
-			}
-		}
+		Timeline::Position const& position = positions[index];
+
+		// what would sound there had the chain played from its start
+		m_timeline->sounding(position.sample, [this](Timeline::Event const& event) {
+			play(event.instrument, event.lane, event.note, event.velocity);
+		});
+
+		m_position = position.sample;
+		m_next_event = m_timeline->seek(position.sample + 1);
+		m_next_position = index;
+		m_state.playing = true;
 	}
 
-	bool Chainer::next() {
-		bool report_state = (m_cfg.action != Sequencer::Action::None);
+	void Chainer::play(InstrumentId instrument, int lane, int note, float velocity) {
+		m_sounding[instrument][lane][note] = velocity;
+		m_engine->setInstrumentNote(instrument, note, velocity, lane);
+	}
 
-		bool play_link = false;
+	void Chainer::releaseSounding() {
+		for (InstrumentId instrument = InstrumentStart; instrument != InstrumentCount; ++instrument)
+			for (int lane = 0; lane != Sequencer::LaneCount; ++lane)
+				for (int note = 0; note != TotalNotes; ++note)
+					if (m_sounding[instrument][lane][note] > 0.0f)
+						play(instrument, lane, note, 0.0f);
+	}
 
-		if (m_state.playing) {
-			if (!m_engine->sequencer().state().playing) {
-				Log::i(TAG, sfmt("%d/%d done", m_state.link_index, m_state.link_run));
-
-				bool looped = advanceToNext();
-
-				//if (looped) {
-				//	m_state.playing = false;
-				//} 
-				//else 
-				{
-					play_link = true;
-				}
-				report_state = true;
-			}
-		}
+	void Chainer::wrap() {
+		if (m_position != m_timeline->length())
+			return;
+
+		// a run always ends releasing everything, the first link starts over clean
+		m_position = 0;
+		m_next_event = 0;
+		m_next_position = 0;
+	}
+
+	bool Chainer::next() {
+		bool report_state = (m_action != Sequencer::Action::None);
 
-		if (m_cfg.action != Sequencer::Action::None) {
+		if (m_action != Sequencer::Action::None) {
 
-			if (m_cfg.action == Sequencer::Action::Stop || m_cfg.action == Sequencer::Action::Pause) {
+			if (m_action == Sequencer::Action::Stop || m_action == Sequencer::Action::Pause) {
 				m_state.playing = false;
 
 				m_state.link_index = 0;
 				m_state.link_run = 0;
 
-				if (m_cfg.action_link >= 0)
-					m_state.link_index = m_cfg.action_link;
+				if (m_cfg->action_link >= 0)
+					m_state.link_index = m_cfg->action_link;
 
 			}
-			else if (m_cfg.valid && (m_cfg.action == Sequencer::Action::Play || m_cfg.action == Sequencer::Action::PlayOnce)) {
-				m_state.playing = true;
+			else if (m_cfg->valid && (m_action == Sequencer::Action::Play || m_action == Sequencer::Action::PlayOnce)) {
+				start(clampAbove(m_cfg->action_link, 0), clampAbove(m_cfg->action_step, 0));
+			}
+			m_action = Sequencer::Action::None;
+		}
 
-				m_state.link_index = 0;
-				m_state.link_run = 0;
+		if (m_state.playing) {
+			auto const& events = m_timeline->events();
+			auto const& positions = m_timeline->positions();
 
-				if (m_cfg.action_link >= 0)
-					m_state.link_index = m_cfg.action_link;
+			for (; m_next_event != events.size() && events[m_next_event].sample == m_position; ++m_next_event)
+				play(events[m_next_event].instrument, events[m_next_event].lane, events[m_next_event].note, events[m_next_event].velocity);
 
-				if (!m_cfg.chain[m_state.link_index].valid)
-					advanceToNext();
+			if (m_next_position != positions.size() && positions[m_next_position].sample == m_position) {
+				Timeline::Position const& position = positions[m_next_position++];
 
-				play_link = true;
-			}
-			m_cfg.action = Sequencer::Action::None;
-		}
+				if (position.link != m_state.link_index || position.run != m_state.link_run)
+					Log::i(TAG, sfmt("%d/%d", position.link, position.run));
 
+				m_state.link_index = position.link;
+				m_state.link_run = position.run;
+				m_state.step = position.step;
+				report_state = true;
+			}
 
-		if (play_link) {
-			Sequencer::Configuration sequence = m_cfg.chain[m_state.link_index].sequence;
-			sequence.action = Sequencer::Action::PlayOnce;
-			m_engine->sequencer().apply(sequence, true);
+			m_position++;
+			wrap();
 		}
 
 		return report_state;
 	}
 
+	int Chainer::horizon() {
+		if (m_action != Sequencer::Action::None)
+			return 0;
+
+		if (!m_state.playing)
+			return std::numeric_limits<int>::max();
+
+		// the next event or step, or looping back to the start
+		auto const& events = m_timeline->events();
+		auto const& positions = m_timeline->positions();
+
+		uint64_t next = m_timeline->length();
+		if (m_next_event != events.size())
+			next = minimum(next, events[m_next_event].sample);
+		if (m_next_position != positions.size())
+			next = minimum(next, positions[m_next_position].sample);
+
+		return int(minimum(next - m_position, uint64_t(std::numeric_limits<int>::max())));
+	}
+
+	void Chainer::skip(int samples) {
+		assert(samples <= horizon());
+
+		if (m_state.playing) {
+			m_position += uint64_t(samples);
+			wrap();
+		}
+	}
+
 	void Chainer::panic() {
 		m_state = State();
+		m_position = 0;
+		m_next_event = 0;
+		m_next_position = 0;
+
+		for (auto& lanes : m_sounding)
+			for (auto& notes : lanes)
+				notes.fill(0.0f);
 	}
 
 }
\ No newline at end of file
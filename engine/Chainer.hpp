@@ -4,6 +4,7 @@
 
 namespace sns {
 
+	class Timeline;
 
 	class Chainer {
 	public:
@@ -20,11 +21,13 @@ namespace sns {
 			std::vector<Link> chain;
 			bool valid = false;
 			int action_link = 0;
+			int action_step = 0; // step of the action link playback starts from
 		};
 
 		struct State {
 			int link_index = 0;
 			int link_run = 0;
+			int step = 0;
 			bool playing = false;
 		};
 
@@ -37,14 +40,35 @@ namespace sns {
 		State state();
 		bool next();
 
-		void apply(Configuration const& cfg);
+		// samples after the current one during which next() has nothing to do
+		int horizon();
+		// moves along the timeline without events, at most horizon()
+		void skip(int samples);
+
+		// validates the links, off the audio thread (the timeline is compiled from the result)
+		static Snapshot<Configuration> prepare(Configuration const& cfg);
+
+		// takes a reference to a prepared snapshot and its compiled timeline, the ones they replace are retired to the engine reclaimer
+		void apply(Snapshot<Configuration> cfg, Snapshot<Timeline> timeline);
 		void panic();
 	private:
 		std::string TAG;
 		Engine* m_engine;
 		State m_state;
-		Configuration m_cfg;
+		Snapshot<Configuration> m_cfg;
+		Snapshot<Timeline> m_timeline;
+		Sequencer::Action m_action; // pending action of m_cfg, the snapshot itself is never modified
+		Snapshot<Sequencer::Configuration> m_stop_sequence;
+
+		// playback of the timeline
+		uint64_t m_position;		// sample next() plays
+		size_t m_next_event;
+		size_t m_next_position;
+		std::array<std::array<std::array<float, TotalNotes>, Sequencer::LaneCount>, InstrumentCount> m_sounding; // velocities
 
-		bool advanceToNext();
+		void start(int link, int step);
+		void play(InstrumentId instrument, int lane, int note, float velocity);
+		void releaseSounding();
+		void wrap();
 	};
 }
\ No newline at end of file
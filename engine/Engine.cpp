@@ -1,9 +1,8 @@
 #include "Engine.hpp"
 #include "core/Log.hpp"
-#include "instrument/SynthMachine.hpp"
 #include "instrument/DrumMachine.hpp"
-#include "instrument/Dx7.hpp"
-#include "instrument/TB303.hpp"
+
+#include <limits>
 
 namespace sns {
 
@@ -12,18 +11,26 @@ namespace sns {
         m_last_fill_samples(0),
         m_produced_samples_counter(0),
         m_synthesis_duration_ms(sns::SampleRate / 2048),
+        m_midi_pending(0),
+        m_midi_latency(0),
+        m_midi_blocks(MidiLatencyBlocks),
+        m_midi_dispatched(false),
+        m_spectrum(m_analyser),
         m_feedback_callback(nullptr)
     {
-        m_instruments[InstrumentIdSynthMachine] = std::make_unique<SynthMachine>();
-        m_instruments[InstrumentIdDrumMachine] = std::make_unique<DrumMachine>();
-        m_instruments[InstrumentIdDx7] = std::make_unique<Dx7>();
-        m_instruments[InstrumentIdTB303] = std::make_unique<TB303>();
+        for (InstrumentId id = InstrumentStart; id != InstrumentCount; ++id) {
+            m_instruments[id] = createInstrument(id);
+            m_instruments[id]->setReclaimer(&m_reclaimer);
+        }
 
         setFeedbackCallback(nullptr);
 
         m_sequencer.setEngine(this);
         m_chainer.setEngine(this);
 
+        m_midi.setSysexPreparer([this](InstrumentId instrument, uint8_t const* data, size_t size) {
+            return m_instruments[instrument] ? m_instruments[instrument]->prepareSysex(data, size) : Prepared();
+        });
         m_midi.startWorking();
     }
 
@@ -42,6 +49,14 @@ namespace sns {
         return m_recorder;
     }
 
+    void Engine::startStemRecording(std::string const& filename, RecordingLayout layout) {
+        std::vector<std::string> stems;
+        for (int i = InstrumentStart; i != InstrumentCount; ++i)
+            stems.push_back(instrumentToString(i));
+
+        m_recorder.startRecording(filename, layout, stems);
+    }
+
     Midi& Engine::midi() {
         return m_midi;
     }
@@ -50,6 +65,14 @@ namespace sns {
         return m_analyser;
     }
 
+    Spectrum& Engine::spectrum() {
+        return m_spectrum;
+    }
+
+    LoudnessMeter& Engine::loudness() {
+        return m_loudness;
+    }
+
     Sequencer& Engine::sequencer() {
         return m_sequencer;
     }
@@ -58,51 +81,57 @@ namespace sns {
         return m_chainer;
     }
 
-    void Engine::stats(float& synthesis_average_ms, uint64_t& produced_ms, int& last_fill_samples) {
+    Reclaimer& Engine::reclaimer() {
+        return m_reclaimer;
+    }
+
+    void Engine::stats(float& synthesis_average_ms, float& synthesis_peak_ms, uint64_t& produced_ms, int& last_fill_samples) {
         std::unique_lock<std::recursive_mutex> lock(m_sync_mutex);
         synthesis_average_ms = m_synthesis_duration_ms.average();
+        synthesis_peak_ms = m_synthesis_duration_ms.percentile(0.99f);
         produced_ms = audioMilliseconds(m_produced_samples_counter);
         last_fill_samples = m_last_fill_samples;
     }
 
+    void Engine::resetMidiLatency() {
+        std::unique_lock<std::recursive_mutex> lock(m_sync_mutex);
+        m_midi_blocks.clear();
+        m_midi_latency = 0;
+    }
+
     void Engine::produceSamples(uint64_t count, float *buffer) {
         std::unique_lock<std::recursive_mutex> lock(m_sync_mutex);
 
         int64_t ts = getCurrentMilliseconds();
 
-        // dispatch midi messages
-        {
-            auto messages = midi().take();
-            for (auto current : messages) 
-                if (m_instruments[current.instrument]) 
-                    m_instruments[current.instrument]->onMidi(current);
-            
-
-            if (!messages.empty()) {
-                for (int i = InstrumentStart; i != InstrumentCount; ++i) {
-                    bool values;
-                    bool notes;
+        // midi messages get their sample in this block or the next
+        m_sample_clock.update(m_produced_samples_counter, double(getCurrentMicroseconds()) / double(Microseconds));
 
-                    m_instruments[i]->takeMidiControllerUpdates(values, notes);
-
-                    if (values)
-                        m_feedback_callback->onInstrumentParamsFeedback(i, m_instruments[i]->getValues());
-
-                     if (notes)
-                        m_feedback_callback->onMidiNotesFeedback(i, m_instruments[i]->getNotesPressedOnMidiController());
-                }
-            }
-        }
+        // the longest of the recent blocks, hosts don't always call with the same size
+        float dropped;
+        m_midi_blocks.add(float(count), dropped);
+        m_midi_latency = uint64_t(m_midi_blocks.percentile(1.0f));
+        takeMidi();
 
         // dispatch actions
         while (!m_actions.empty()) {
-            auto action = m_actions.front();
+            auto action = std::move(m_actions.front());
             m_actions.pop_front();
             action();
         }
 
 
-        for (uint64_t s = 0; s != count; ++s) {
+        // stems are gathered as interleaved frames: master then each instrument
+        const bool recording = m_recorder.isAccepting();
+        const bool stems = recording && (m_recorder.tracks() == StemTracks);
+
+        uint64_t s = 0;
+        while (s != count) {
+            //
+            // midi due now
+            //
+            const int midi_horizon = dispatchMidi();
+
             //
             // update chainer
             //
@@ -114,37 +143,86 @@ namespace sns {
             //
             if (m_sequencer.next()) 
                 m_feedback_callback->onSequencerState(m_sequencer.state());
-            
-            //
-            // render instruments
-            //
-            float sample = 0.0f;
-            for (int i = InstrumentStart; i != InstrumentCount; ++i)
-                sample += m_instruments[i]->next();
-                
-            // make sure we don't go overboard
-            sample = HardClip(sample);
 
             //
-            // send to output
+            // nothing happens on the transport until the horizon, render up to it in one go
             //
-            buffer[s] = sample;
-            
+            const int horizon = minimum(minimum(m_chainer.horizon(), m_sequencer.horizon()), midi_horizon);
+            const int run = int(minimum(count - s, uint64_t(minimum(horizon, RenderBlock - 1)) + 1));
+            m_chainer.skip(run - 1);
+            m_sequencer.skip(run - 1);
+
             //
-            // send to recording
+            // render instruments
             //
-            if (m_recorder.isAccepting()) {
-                m_recorder.push(sample);
+            float* output = buffer + s;
+            std::fill(output, output + run, 0.0f);
+
+            for (int i = InstrumentStart; i != InstrumentCount; ++i) {
+                if (stems) {
+                    float* block = m_instrument_block.data();
+                    std::fill(block, block + run, 0.0f);
+                    m_instruments[i]->render(block, run);
+
+                    for (int f = 0; f != run; ++f) {
+                        m_stem_frames[f * StemTracks + 1 + i - InstrumentStart] = block[f];
+                        output[f] += block[f];
+                    }
+                }
+                else {
+                    m_instruments[i]->render(output, run);
+                }
             }
 
-            //
-            // send to analyser
-            //
-            if (m_analyser.isAccepting()) {
-                m_analyser.push(sample);
+            // make sure we don't go overboard
+            for (int f = 0; f != run; ++f)
+                output[f] = HardClip(output[f]);
+
+            if (stems) {
+                for (int f = 0; f != run; ++f)
+                    m_stem_frames[f * StemTracks] = output[f];
+                m_recorder.push(m_stem_frames.data(), run);
             }
 
-            m_produced_samples_counter++;
+            m_produced_samples_counter += uint64_t(run);
+            s += uint64_t(run);
+        }
+
+        // what midi controllers changed
+        if (m_midi_dispatched) {
+            m_midi_dispatched = false;
+
+            for (int i = InstrumentStart; i != InstrumentCount; ++i) {
+                bool values;
+                bool notes;
+
+                m_instruments[i]->takeMidiControllerUpdates(values, notes);
+
+                if (values)
+                    m_feedback_callback->onInstrumentParamsFeedback(i, m_instruments[i]->getValues());
+
+                if (notes)
+                    m_feedback_callback->onMidiNotesFeedback(i, m_instruments[i]->getNotesPressedOnMidiController());
+            }
+        }
+
+        //
+        // meters
+        //
+        m_loudness.process(buffer, int(count));
+
+        //
+        // send to recording, the whole block at once (stems went along the runs)
+        //
+        if (recording && !stems && m_recorder.tracks() == 1) {
+            m_recorder.push(buffer, int(count));
+        }
+
+        //
+        // send to analyser, the whole block at once
+        //
+        if (m_analyser.isAccepting()) {
+            m_analyser.push(buffer, int(count));
         }
 
         int64_t work_duration = getCurrentMilliseconds() - ts;
@@ -152,6 +230,59 @@ namespace sns {
         m_last_fill_samples = int(count);
     }
 
+    void Engine::takeMidi() {
+        const uint64_t start = m_produced_samples_counter;
+        const size_t taken = midi().take(m_midi_messages.data() + m_midi_pending, m_midi_messages.size() - m_midi_pending);
+
+        // latest sample pending per port, nothing is scheduled before it
+        std::array<uint64_t, Midi::MaxPorts> latest;
+        latest.fill(start);
+        for (size_t i = 0; i != m_midi_pending; ++i)
+            latest[m_midi_messages[i].port] = maximum(latest[m_midi_messages[i].port], m_midi_samples[i]);
+
+        for (size_t i = m_midi_pending; i != m_midi_pending + taken; ++i) {
+            // sent during the previous block, played as much later as the longest block: constant latency
+            // instead of everything at the block start (a sysex is played as soon as its port allows)
+            const double at = m_sample_clock.sampleAt(m_midi_messages[i].timestamp) + double(m_midi_latency);
+            uint64_t sample = (at > double(start)) ? uint64_t(at) : start;
+            sample = minimum(sample, start + m_midi_latency);
+
+            uint64_t& port_latest = latest[m_midi_messages[i].port];
+            port_latest = maximum(port_latest, m_midi_messages[i].sysex ? start : sample);
+            m_midi_samples[i] = port_latest;
+        }
+
+        m_midi_pending += taken;
+    }
+
+    int Engine::dispatchMidi() {
+        const uint64_t now = m_produced_samples_counter;
+        uint64_t next = std::numeric_limits<uint64_t>::max();
+
+        // in the order taken, a port's messages never overtake each other
+        size_t kept = 0;
+        for (size_t i = 0; i != m_midi_pending; ++i) {
+            if (m_midi_samples[i] <= now) {
+                MidiMessage const& message = m_midi_messages[i];
+                if (m_instruments[message.instrument])
+                    m_instruments[message.instrument]->onMidi(message);
+                midi().played(message);
+                m_midi_dispatched = true;
+            }
+            else {
+                next = minimum(next, m_midi_samples[i]);
+                m_midi_messages[kept] = m_midi_messages[i];
+                m_midi_samples[kept] = m_midi_samples[i];
+                kept++;
+            }
+        }
+        m_midi_pending = kept;
+
+        if (next == std::numeric_limits<uint64_t>::max())
+            return std::numeric_limits<int>::max();
+        return int(minimum(next - now - 1, uint64_t(std::numeric_limits<int>::max())));
+    }
+
     void Engine::fill(float* buffer, int num_frames, int num_channels) {
         int needed_samples = num_frames * num_channels;
         produceSamples(needed_samples, buffer);
@@ -161,32 +292,77 @@ namespace sns {
         assert(instrument_id > 0);
         assert(instrument_id < InstrumentCount);
 
+        // whatever is expensive to derive from the values is done here, the audio thread only takes it
+        Prepared prepared = m_instruments[instrument_id]->prepareValues(values);
+        reclaim();
+
 		std::unique_lock<std::recursive_mutex> lock(m_sync_mutex);
-        auto action = [this, instrument_id, values] { m_instruments[instrument_id]->setValues(values); };
+        auto action = [this, instrument_id, values, prepared]() mutable {
+            m_instruments[instrument_id]->takePrepared(prepared);
+            m_instruments[instrument_id]->setValues(values);
+            m_reclaimer.retire(std::move(prepared));
+        };
         m_actions.push_back(action);
 	}
 
-	void Engine::setInstrumentNote(InstrumentId instrument_id, int note, float velocity) {
+	void Engine::setInstrumentNote(InstrumentId instrument_id, int note, float velocity, int lane) {
         assert(instrument_id > 0);
         assert(instrument_id < InstrumentCount);
 
 		std::unique_lock<std::recursive_mutex> lock(m_sync_mutex);
-        auto action = [this, instrument_id, note, velocity] { m_instruments[instrument_id]->setNote(note, velocity); };
+        auto action = [this, instrument_id, note, velocity, lane] { m_instruments[instrument_id]->setLaneNote(lane, note, velocity); };
         m_actions.push_back(action);
 	}
 
     void Engine::setSequencerConfiguration(Sequencer::Configuration const& configuration) {
+        // copied once here, the audio thread only ever gets a reference
+        auto snapshot = std::make_shared<Sequencer::Configuration const>(configuration);
+        reclaim();
+
         std::unique_lock<std::recursive_mutex> lock(m_sync_mutex);
-        auto action = [this, configuration] { m_sequencer.apply(configuration); };
+        auto action = [this, snapshot] { m_sequencer.apply(snapshot); };
         m_actions.push_back(action);
     }
 
     void Engine::setChainerConfiguration(Chainer::Configuration const& configuration) {
+        auto snapshot = Chainer::prepare(configuration);
+        auto timeline = std::make_shared<Timeline const>(Timeline::compile(*snapshot));
+        reclaim();
+
+        std::unique_lock<std::recursive_mutex> lock(m_sync_mutex);
+        auto action = [this, snapshot, timeline] { m_chainer.apply(snapshot, timeline); };
+        m_actions.push_back(action);
+    }
+
+    void Engine::setDrumMachineFont(std::string const& filename) {
+        static_cast<DrumMachine*>(m_instruments[InstrumentIdDrumMachine].get())->loadSoundFont(filename);
+    }
+
+    void Engine::playTimeline(Timeline const& timeline) {
+        // the link only gives the chainer something to start, the timeline already holds the notes
+        Chainer::Configuration configuration;
+        configuration.action = Sequencer::Action::Play;
+        configuration.valid = !timeline.empty();
+
+        Chainer::Link link;
+        link.name = "timeline";
+        link.runs = 1;
+        link.valid = configuration.valid;
+        configuration.chain.push_back(link);
+
+        auto snapshot = std::make_shared<Chainer::Configuration const>(configuration);
+        auto compiled = std::make_shared<Timeline const>(timeline);
+        reclaim();
+
         std::unique_lock<std::recursive_mutex> lock(m_sync_mutex);
-        auto action = [this, configuration] { m_chainer.apply(configuration); };
+        auto action = [this, snapshot, compiled] { m_chainer.apply(snapshot, compiled); };
         m_actions.push_back(action);
     }
 
+    void Engine::reclaim() {
+        m_reclaimer.collect();
+    }
+
     void Engine::panic() {
         std::unique_lock<std::recursive_mutex> lock(m_sync_mutex);
         auto action = [this] { 
@@ -4,10 +4,14 @@
 #include "audio/RunningStats.hpp"
 #include "audio/Recorder.hpp"
 #include "audio/Midi.hpp"
+#include "audio/MidiClock.hpp"
 #include "audio/Analyser.hpp"
+#include "audio/Spectrum.hpp"
+#include "audio/Loudness.hpp"
 #include "instrument/Instrument.hpp"
 #include "Sequencer.hpp"
 #include "Chainer.hpp"
+#include "Timeline.hpp"
 
 namespace sns {
 
@@ -30,23 +34,43 @@ namespace sns {
 		void setFeedbackCallback(FeedbackCallback* callback);
 
 		Recorder& recorder();
+
+		// records the master and each instrument before the mix
+		void startStemRecording(std::string const& filename, RecordingLayout layout);
 		Midi& midi();
 		Analyser& analyser();
+		Spectrum& spectrum();
+		LoudnessMeter& loudness();
 		Sequencer& sequencer();
 		Chainer& chainer();
+		Reclaimer& reclaimer();
 
 		void fill(float* buffer, int num_frames, int num_channels);
-		void stats(float& synthesis_average_ms, uint64_t& produced_ms, int& last_fill_samples);
+		// the audio device is set up again, the midi latency forgets the blocks of the previous buffer size
+		void resetMidiLatency();
+		void stats(float& synthesis_average_ms, float& synthesis_peak_ms, uint64_t& produced_ms, int& last_fill_samples);
 
 		void setInstrumentParams(InstrumentId instrument_id, ParametersValues const& values);
-		void setInstrumentNote(InstrumentId instrument_id, int note, float velocity);
+		void setInstrumentNote(InstrumentId instrument_id, int note, float velocity, int lane = 0);
 		void setSequencerConfiguration(Sequencer::Configuration const& configuration);
 		void setChainerConfiguration(Chainer::Configuration const& configuration);
+		// kit of the drum machine, a user SF2 loaded in the background or the embedded kit when empty
+		void setDrumMachineFont(std::string const& filename);
+		// plays a timeline (an imported midi file) through the chainer as a single link, looping
+		void playTimeline(Timeline const& timeline);
+
+		// releases the configuration snapshots the audio thread is done with, call regularly off the audio thread
+		void reclaim();
 
 		void produceSamples(uint64_t count, float* buffer);
 
 		void panic();
 	private:
+		static constexpr int StemTracks = 1 + InstrumentCount - InstrumentStart; // master and instruments
+		static constexpr int RenderBlock = 256; // longest run rendered without looking at the transport
+		static constexpr int MidiBatch = 256; // messages pending, the rest waits in the midi queues
+		static constexpr int MidiLatencyBlocks = 32; // blocks the midi latency looks back on
+
 		std::string TAG;
 		std::recursive_mutex m_sync_mutex;
 		int m_last_fill_samples; // last filled samples
@@ -55,14 +79,30 @@ namespace sns {
 
 		std::array<std::unique_ptr<BaseInstrument>, InstrumentCount> m_instruments;
 		Recorder m_recorder;
+		std::array<float, RenderBlock * StemTracks> m_stem_frames;
+		std::array<float, RenderBlock> m_instrument_block;
 		Midi m_midi;
+		std::array<MidiMessage, MidiBatch> m_midi_messages;
+		std::array<uint64_t, MidiBatch> m_midi_samples; // sample each pending message plays at
+		size_t m_midi_pending;
+		uint64_t m_midi_latency; // samples, the longest recent block
+		RunningWindow m_midi_blocks; // sizes of the recent blocks
+		bool m_midi_dispatched;
+		SampleClock m_sample_clock;
+		Reclaimer m_reclaimer;
 		Sequencer m_sequencer;
 		Chainer m_chainer;
 		Analyser m_analyser;
+		Spectrum m_spectrum;
+		LoudnessMeter m_loudness;
 
 		std::list<std::function<void()>> m_actions;
 
 		FeedbackCallback* m_feedback_callback;
+
+		void takeMidi();
+		// plays the messages due at the current sample, returns the samples after it until the next one
+		int dispatchMidi();
 	};
 
 }
\ No newline at end of file
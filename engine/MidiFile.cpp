@@ -0,0 +1,249 @@
+#include "MidiFile.hpp"
+#include "core/Log.hpp"
+#include "core/MappedFile.hpp"
+
+#include "tsf/tml.h"
+
+#include <cstring>
+
+namespace sns {
+
+	constexpr int DrumChannel = 9;
+	constexpr int Division = 960; // ticks per quarter note (a step)
+	constexpr char const* Signature = "Senos"; // text event opening the tempo track of the files save writes
+
+	//
+	// Track chunk data, events are added in time order
+	//
+	struct MidiTrack {
+		std::vector<uint8_t> data;
+		uint32_t tick = 0;
+
+		void delta(uint32_t at) {
+			uint32_t value = at - tick;
+			tick = at;
+
+			// variable length quantity, 7 bits at a time most significant first
+			uint8_t bytes[5];
+			int count = 0;
+			do {
+				bytes[count++] = uint8_t(value & 0x7f);
+				value >>= 7;
+			} while (value);
+
+			while (count--)
+				data.push_back(bytes[count] | (count ? 0x80 : 0x00));
+		}
+
+		void event(uint32_t at, uint8_t status, uint8_t first, uint8_t second) {
+			delta(at);
+			data.push_back(status);
+			data.push_back(first);
+			data.push_back(second);
+		}
+
+		void meta(uint32_t at, uint8_t type, std::vector<uint8_t> const& payload) {
+			delta(at);
+			data.push_back(0xff);
+			data.push_back(type);
+			data.push_back(uint8_t(payload.size()));
+			data.insert(data.end(), payload.begin(), payload.end());
+		}
+
+		void text(uint32_t at, uint8_t type, std::string const& value) {
+			meta(at, type, std::vector<uint8_t>(value.begin(), value.begin() + minimum(value.size(), size_t(127))));
+		}
+	};
+
+	static void write32(std::vector<uint8_t>& output, uint32_t value) {
+		for (int shift = 24; shift >= 0; shift -= 8)
+			output.push_back(uint8_t(value >> shift));
+	}
+
+	static void write16(std::vector<uint8_t>& output, uint16_t value) {
+		output.push_back(uint8_t(value >> 8));
+		output.push_back(uint8_t(value));
+	}
+
+	static void writeTag(std::vector<uint8_t>& output, char const (&tag)[5]) {
+		for (int i = 0; i != 4; ++i)
+			output.push_back(uint8_t(tag[i]));
+	}
+
+	MidiFile::Mapping MidiFile::defaultMapping() {
+		Mapping mapping;
+		for (int channel = 0; channel != Channels; ++channel) {
+			mapping[channel].instrument = (channel == DrumChannel) ? InstrumentIdDrumMachine : InstrumentIdDx7;
+			mapping[channel].lane = channel % Sequencer::LaneCount;
+		}
+		return mapping;
+	}
+
+	int MidiFile::channel(InstrumentId instrument, int lane) {
+		static_assert((InstrumentCount - InstrumentStart) * Sequencer::LaneCount == Channels, "a channel per lane");
+
+		if (instrument == InstrumentIdDrumMachine && lane == 0)
+			return DrumChannel;
+
+		// the other lanes in instrument then lane order, around the drum channel
+		int index = (instrument - InstrumentStart) * Sequencer::LaneCount + clampTo(lane, 0, Sequencer::LaneCount - 1);
+		if (instrument >= InstrumentIdDrumMachine)
+			index--;
+		return (index < DrumChannel) ? index : index + 1;
+	}
+
+	MidiFile::Mapping MidiFile::instrumentMapping() {
+		Mapping mapping;
+		for (InstrumentId instrument = InstrumentStart; instrument != InstrumentCount; ++instrument)
+			for (int lane = 0; lane != Sequencer::LaneCount; ++lane)
+				mapping[channel(instrument, lane)] = { instrument, lane };
+		return mapping;
+	}
+
+	// the first event of the first track is the signature text save writes
+	static bool isSavedFile(uint8_t const* data, size_t size) {
+		if (size < 8 || memcmp(data, "MThd", 4) != 0)
+			return false;
+
+		const size_t track = 8 + ((size_t(data[4]) << 24) | (size_t(data[5]) << 16) | (size_t(data[6]) << 8) | size_t(data[7]));
+		const size_t length = strlen(Signature);
+		if (size < track + 12 + length || memcmp(data + track, "MTrk", 4) != 0)
+			return false;
+
+		uint8_t const* event = data + track + 8;
+		return event[0] == 0 && event[1] == 0xff && event[2] == 0x01 && event[3] == length && memcmp(event + 4, Signature, length) == 0;
+	}
+
+	static Timeline loadMapped(std::string const& filename, MappedFile const& file, MidiFile::Mapping const& mapping) {
+		tml_message* messages = tml_load_memory(file.data(), int(file.size()));
+		if (!messages) {
+			Log::e("MidiFile", sfmt("No midi messages in %s", filename));
+			return Timeline();
+		}
+
+		std::vector<Timeline::Event> events;
+		for (tml_message* message = messages; message; message = message->next) {
+			if (message->type != TML_NOTE_ON && message->type != TML_NOTE_OFF)
+				continue;
+
+			MidiFile::Target const& target = mapping[message->channel & 0x0f];
+			if (target.instrument == InstrumentIdNone)
+				continue;
+
+			Timeline::Event event;
+			event.sample = samplesFromMilliseconds(uint64_t(clampAbove(int(message->time), 0)));
+			event.instrument = target.instrument;
+			event.lane = target.lane;
+			event.note = message->key;
+			event.velocity = (message->type == TML_NOTE_ON) ? float(message->velocity) / 127.0f : 0.0f;
+			events.push_back(event);
+		}
+		tml_free(messages);
+
+		Timeline timeline = Timeline::fromEvents(std::move(events));
+		Log::i("MidiFile", sfmt("Loaded %s, %d events, %d ms", filename, int(timeline.events().size()), int(audioMilliseconds(timeline.length()))));
+		return timeline;
+	}
+
+	Timeline MidiFile::load(std::string const& filename, Mapping const& mapping) {
+		MappedFile file;
+		if (!file.open(filename)) {
+			Log::e("MidiFile", sfmt("Unable to open %s", filename));
+			return Timeline();
+		}
+
+		return loadMapped(filename, file, mapping);
+	}
+
+	Timeline MidiFile::load(std::string const& filename) {
+		MappedFile file;
+		if (!file.open(filename)) {
+			Log::e("MidiFile", sfmt("Unable to open %s", filename));
+			return Timeline();
+		}
+
+		return loadMapped(filename, file, isSavedFile(file.data(), file.size()) ? instrumentMapping() : defaultMapping());
+	}
+
+	bool MidiFile::save(std::string const& filename, Sequencer::Configuration const& cfg) {
+		Chainer::Configuration chain;
+		chain.chain.push_back({ "sequence", 1, cfg });
+		return save(filename, chain);
+	}
+
+	bool MidiFile::save(std::string const& filename, Chainer::Configuration const& cfg) {
+		// every link from its first step
+		Chainer::Configuration prepared = *Chainer::prepare(cfg);
+		for (auto& link : prepared.chain)
+			link.sequence.action_step = 0;
+		Timeline timeline = Timeline::compile(prepared);
+
+		std::vector<MidiTrack> tracks(1 + InstrumentCount - InstrumentStart);
+		tracks[0].text(0, 0x01, Signature);
+		tracks[0].text(0, 0x03, prepared.chain.size() == 1 ? prepared.chain[0].name : "chain");
+		for (InstrumentId instrument = InstrumentStart; instrument != InstrumentCount; ++instrument)
+			tracks[1 + instrument - InstrumentStart].text(0, 0x03, instrumentToString(instrument));
+
+		// every position is a step, a quarter note after the previous one (runs restart a sample later)
+		auto const& positions = timeline.positions();
+		auto const& events = timeline.events();
+		int tempo = 0;
+		int link = -1;
+
+		for (size_t p = 0, e = 0; p != positions.size(); ++p) {
+			Timeline::Position const& position = positions[p];
+			Sequencer::Configuration const& sequence = prepared.chain[position.link].sequence;
+			const uint32_t tick = uint32_t(p) * Division;
+
+			if (position.link != link) {
+				link = position.link;
+				tracks[0].text(tick, 0x06, prepared.chain[link].name);
+			}
+
+			if (sequence.tempo != tempo) {
+				tempo = sequence.tempo;
+				const uint32_t microseconds = uint32_t(60 * Microseconds / uint64_t(tempo));
+				tracks[0].meta(tick, 0x51, { uint8_t(microseconds >> 16), uint8_t(microseconds >> 8), uint8_t(microseconds) });
+			}
+
+			// the events up to the next step, the release closing a run included
+			const uint64_t beat_samples = uint64_t((SampleRate * 60) / sequence.tempo);
+			const uint64_t end = (p + 1 != positions.size()) ? positions[p + 1].sample : timeline.length();
+
+			for (; e != events.size() && events[e].sample < end; ++e) {
+				Timeline::Event const& event = events[e];
+				const uint64_t offset = minimum(event.sample - position.sample, beat_samples);
+				const uint32_t at = tick + uint32_t((offset * Division + beat_samples / 2) / beat_samples);
+
+				const uint8_t status = uint8_t(channel(event.instrument, event.lane) | (event.velocity > 0.0f ? 0x90 : 0x80));
+				const uint8_t velocity = uint8_t(clampTo(int(event.velocity * 127.0f + 0.5f), 1, 127));
+				tracks[1 + event.instrument - InstrumentStart].event(at, status, uint8_t(event.note & 0x7f), event.velocity > 0.0f ? velocity : 0);
+			}
+		}
+
+		const uint32_t song_end = uint32_t(positions.size()) * Division;
+
+		std::vector<uint8_t> output;
+		writeTag(output, "MThd");
+		write32(output, 6);
+		write16(output, 1);
+		write16(output, uint16_t(tracks.size()));
+		write16(output, Division);
+
+		for (auto& track : tracks) {
+			track.meta(maximum(track.tick, song_end), 0x2f, {});
+
+			writeTag(output, "MTrk");
+			write32(output, uint32_t(track.data.size()));
+			output.insert(output.end(), track.data.begin(), track.data.end());
+		}
+
+		if (!writeRawBinary(filename, output)) {
+			Log::e("MidiFile", sfmt("Unable to write %s", filename));
+			return false;
+		}
+
+		Log::i("MidiFile", sfmt("Saved %s, %d steps", filename, int(positions.size())));
+		return true;
+	}
+}
\ No newline at end of file
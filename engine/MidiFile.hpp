@@ -0,0 +1,43 @@
+#pragma once
+
+#include "Timeline.hpp"
+
+namespace sns {
+
+	//
+	// Standard MIDI files as timelines the engine plays or renders (only the notes are taken),
+	// and sequences or chains written out as their notes
+	//
+	class MidiFile {
+	public:
+		static constexpr int Channels = 16;
+
+		struct Target {
+			InstrumentId instrument = InstrumentIdNone; // none drops the channel
+			int lane = 0;
+		};
+		using Mapping = std::array<Target, Channels>;
+
+		// general midi drums (channel 10) on the drum machine, every other channel on a dx7 lane
+		static Mapping defaultMapping();
+
+		// tracks are merged, their channels pick the instrument, times are resolved to the millisecond by tml
+		// returns an empty timeline when the file can't be read
+		static Timeline load(std::string const& filename, Mapping const& mapping);
+		// files written by save are mapped back with instrumentMapping, any other with defaultMapping
+		static Timeline load(std::string const& filename);
+
+		// a format 1 file, a tempo track with a marker per link then a track per instrument, each lane on its own channel.
+		// A step is a quarter note at the sequence tempo and the duty sets the note lengths, loading it gives the same
+		// events to the millisecond
+		static bool save(std::string const& filename, Chainer::Configuration const& cfg);
+		// the sequence played once from its first step
+		static bool save(std::string const& filename, Sequencer::Configuration const& cfg);
+
+		// channel save writes a lane of the instrument on, every lane of every instrument has its own.
+		// The first drum lane is on channel 10
+		static int channel(InstrumentId instrument, int lane);
+		// channels mapped back to the instruments and lanes save wrote them from
+		static Mapping instrumentMapping();
+	};
+}
\ No newline at end of file
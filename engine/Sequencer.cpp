@@ -2,6 +2,9 @@
 #include "core/Log.hpp"
 #include "Engine.hpp"
 
+#include <bit>
+#include <limits>
+
 namespace sns {
 
 	std::string toString(Sequencer::Action action) {
@@ -31,37 +34,136 @@ namespace sns {
 
 
 
-	Sequencer::NoteMode Sequencer::Configuration::stepState(InstrumentId instrument, int step, int note) {
-		auto found = instruments[instrument].steps.find(std::pair<int, int>(step, note));
-		if (found != instruments[instrument].steps.end())
-			return found->second;
-		return Sequencer::NoteMode::Off;
+	//
+	// StepGrid
+	//
+	int Sequencer::StepGrid::bitIndex(uint64_t bits) {
+		return std::countr_zero(bits);
+	}
+
+	Sequencer::StepGrid::NoteBits Sequencer::StepGrid::Cells::active() const {
+		NoteBits bits;
+		for (int word = 0; word != Words; ++word)
+			bits[word] = low[word] | high[word];
+		return bits;
+	}
+
+	Sequencer::StepGrid::NoteBits Sequencer::StepGrid::Cells::holds() const {
+		NoteBits bits;
+		for (int word = 0; word != Words; ++word)
+			bits[word] = low[word] & high[word];
+		return bits;
+	}
+
+	Sequencer::StepGrid::NoteBits Sequencer::StepGrid::Cells::accents() const {
+		NoteBits bits;
+		for (int word = 0; word != Words; ++word)
+			bits[word] = ~low[word] & high[word];
+		return bits;
+	}
+
+	Sequencer::NoteMode Sequencer::StepGrid::Cells::get(int note) const {
+		const uint64_t mask = uint64_t(1) << (note % 64);
+		const int word = note / 64;
+		return NoteMode(((low[word] & mask) ? 1 : 0) | ((high[word] & mask) ? 2 : 0));
+	}
+
+	void Sequencer::StepGrid::Cells::set(int note, NoteMode mode) {
+		static_assert(int(NoteMode::Count) <= 4, "NoteMode must fit in 2 bits");
+
+		const uint64_t mask = uint64_t(1) << (note % 64);
+		const int word = note / 64;
+		low[word] = (int(mode) & 1) ? (low[word] | mask) : (low[word] & ~mask);
+		high[word] = (int(mode) & 2) ? (high[word] | mask) : (high[word] & ~mask);
 	}
 
-	void Sequencer::Configuration::setStepState(InstrumentId instrument, int step, int note, NoteMode value) {
-		auto key = std::pair<int, int>(step, note);
+	Sequencer::StepGrid::NoteBits Sequencer::StepGrid::Cells::release(Cells const& next) {
+		const NoteBits sounding = active();
+		const NoteBits sounding_holds = holds();
+		const NoteBits next_active = next.active();
+		const NoteBits next_accents = next.accents();
 
-		if (value == Sequencer::NoteMode::Off) {
-			instruments[instrument].steps.erase(key);
+		NoteBits released;
+		for (int word = 0; word != Words; ++word) {
+			const uint64_t keep = sounding_holds[word] & next_active[word] & ~next_accents[word];
+			released[word] = sounding[word] & ~keep;
+
+			low[word] &= keep;
+			high[word] &= keep;
 		}
-		else {
-			instruments[instrument].steps[key] = value;
+		return released;
+	}
+
+	Sequencer::StepGrid::NoteBits Sequencer::StepGrid::Cells::press(Cells const& next) {
+		const NoteBits sounding = active();
+		const NoteBits next_active = next.active();
+
+		NoteBits pressed;
+		for (int word = 0; word != Words; ++word)
+			pressed[word] = next_active[word] & ~sounding[word];
+
+		// started notes and the holds carried on now play with the step mode
+		*this = next;
+		return pressed;
+	}
+
+	Sequencer::NoteMode Sequencer::StepGrid::get(int step, int note) const {
+		if (step < 0 || step >= int(m_steps.size()) || note < 0 || note >= TotalNotes)
+			return NoteMode::Off;
+		return m_steps[step].get(note);
+	}
+
+	void Sequencer::StepGrid::set(int step, int note, NoteMode mode) {
+		if (step < 0 || step >= MaxSteps || note < 0 || note >= TotalNotes)
+			return;
+
+		if (step >= int(m_steps.size())) {
+			if (mode == NoteMode::Off)
+				return;
+			m_steps.resize(step + 1);
 		}
+
+		m_steps[step].set(note, mode);
+	}
+
+	void Sequencer::StepGrid::clear() {
+		m_steps.clear();
+	}
+
+	bool Sequencer::StepGrid::empty() const {
+		for (auto const& cells : m_steps)
+			for (uint64_t bits : cells.active())
+				if (bits)
+					return false;
+		return true;
 	}
 
-	void Sequencer::Configuration::toggleStepState(InstrumentId instrument, int step, int note) {
-		NoteMode value = stepState(instrument, step, note);
+	Sequencer::StepGrid::Cells const& Sequencer::StepGrid::step(int step) const {
+		static const Cells off;
+		return (step >= 0 && step < int(m_steps.size())) ? m_steps[step] : off;
+	}
+
+
+	Sequencer::NoteMode Sequencer::Configuration::stepState(InstrumentId instrument, int lane, int step, int note) {
+		return instruments[instrument].lanes[lane].get(step, note);
+	}
+
+	void Sequencer::Configuration::setStepState(InstrumentId instrument, int lane, int step, int note, NoteMode value) {
+		instruments[instrument].lanes[lane].set(step, note, value);
+	}
+
+	void Sequencer::Configuration::toggleStepState(InstrumentId instrument, int lane, int step, int note) {
+		NoteMode value = stepState(instrument, lane, step, note);
 		value = (value == NoteMode::Off) ? NoteMode::Press : NoteMode::Off;
-		setStepState(instrument, step, note, value);
+		setStepState(instrument, lane, step, note, value);
 	}
 
 	Sequencer::Sequencer()
 		:TAG("Sequencer"),
-		m_engine(nullptr)
+		m_engine(nullptr),
+		m_action(Action::None)
 	{
-
-		m_cfg.tempo = 0;
-		apply(Configuration());
+		apply(std::make_shared<Configuration const>());
 		panic();
 	}
 
@@ -73,7 +175,8 @@ namespace sns {
 		return m_state;
 	}
 
-	void Sequencer::apply(Configuration const& cfg, bool chaining) {
+	void Sequencer::apply(Snapshot<Configuration> snapshot, bool chaining) {
+		Configuration const& cfg = *snapshot;
 
 		if (cfg.action != Sequencer::Action::None)
 			Log::i(TAG, sfmt("Sequencer::action=%s action_step=%d", toString(cfg.action), cfg.action_step));
@@ -88,11 +191,11 @@ namespace sns {
 		}
 
 
-		if (cfg.step_count != m_cfg.step_count) {
+		if (!m_cfg || cfg.step_count != m_cfg->step_count) {
 			m_state.active_step = m_state.active_step % cfg.step_count;
 		}
 
-		bool compute_samples = (cfg.tempo != m_cfg.tempo) || !equivalent(cfg.duty, m_cfg.duty);
+		bool compute_samples = !m_cfg || (cfg.tempo != m_cfg->tempo) || !equivalent(cfg.duty, m_cfg->duty);
 
 		if (compute_samples) {
 			m_beat_samples = (SampleRate * 60) / cfg.tempo;
@@ -100,25 +203,11 @@ namespace sns {
 		}
 
 
-		StepNotes steps(cfg.step_count);
-		for (InstrumentId instrument = InstrumentStart; instrument != InstrumentCount; ++instrument) {
-			auto const& idata = cfg.instruments[instrument];
-			if (idata.muted) continue;
+		if (m_engine)
+			m_engine->reclaimer().retire(std::move(m_cfg));
 
-			for (auto const& [step_note, note_mode] : idata.steps) {
-				auto [step, note] = step_note;
-				if (note_mode == NoteMode::Off)
-					continue;
-
-				if (step >= steps.size())
-					continue;
-
-				steps[step].push_back({ instrument, note , note_mode });
-			}
-		}
-		std::swap(steps, m_steps);
-
-		m_cfg = cfg;
+		m_cfg = std::move(snapshot);
+		m_action = m_cfg->action;
 		m_cfg_changed = true;
 		m_state.chaining = chaining;
 	}
@@ -127,34 +216,34 @@ namespace sns {
 		bool start_notes = false;
 		bool report_state = m_cfg_changed;
 
-		if (m_cfg.action != Sequencer::Action::None) {
-			if (m_cfg.action == Sequencer::Action::TogglePlay) {
-				m_cfg.action = (m_state.playing) ? Sequencer::Action::Pause : Sequencer::Action::Play;
+		if (m_action != Sequencer::Action::None) {
+			if (m_action == Sequencer::Action::TogglePlay) {
+				m_action = (m_state.playing) ? Sequencer::Action::Pause : Sequencer::Action::Play;
 			}
 
-			if (m_cfg.action == Sequencer::Action::Pause) {
+			if (m_action == Sequencer::Action::Pause) {
 
 				stopAllPlayingNotes();
 
 				m_state.playing = false;
 
 			}
-			else if (m_cfg.action == Sequencer::Action::Play || m_cfg.action == Sequencer::Action::PlayOnce) {
+			else if (m_action == Sequencer::Action::Play || m_action == Sequencer::Action::PlayOnce) {
 
 				m_state.playing = true;
-				m_state.once = m_cfg.action == Sequencer::Action::PlayOnce;
+				m_state.once = m_action == Sequencer::Action::PlayOnce;
 
-				if (m_cfg.action_step >= 0)
-					m_state.active_step = m_cfg.action_step;
+				if (m_cfg->action_step >= 0)
+					m_state.active_step = m_cfg->action_step;
 
 				m_samples_since_last_beat = 0;
 				start_notes = true;
 				//Log::d(TAG, sfmt("Sequencer::Action::Play %d %d", m_state.active_step, m_samples_since_last_beat));
 			}
 
-			m_state.active_step = m_state.active_step % m_cfg.step_count;
+			m_state.active_step = m_state.active_step % m_cfg->step_count;
 			report_state = true;
-			m_cfg.action = Sequencer::Action::None;
+			m_action = Sequencer::Action::None;
 		}
 
 
@@ -166,7 +255,7 @@ namespace sns {
 			// track steps
 			if (do_next_step) {
 				//Log::d(TAG, sfmt("Step Change from %d %d", m_state.active_step, m_samples_since_last_beat));
-				m_state.active_step = (m_state.active_step + 1) % m_cfg.step_count;
+				m_state.active_step = (m_state.active_step + 1) % m_cfg->step_count;
 				m_samples_since_last_beat = 0;
 
 				// stop when we reached the end
@@ -199,89 +288,71 @@ namespace sns {
 		return report_state;
 	}
 
-	void Sequencer::stopAllPlayingNotes() {
-		for (auto const& [step_instrument, step_note, step_note_mode] : m_playing_notes) {
-			m_engine->setInstrumentNote(step_instrument, step_note, 0.0f);
-		}
-		m_playing_notes.clear();
-	}
-
-	void Sequencer::stopPlayingPreviousNotes(bool duty_end) {
-		auto iterator = m_playing_notes.begin();
-		while (iterator != m_playing_notes.end()) {
-			bool erase = false;
-
-			auto const& [playing_instrument, playing_note, playing_note_mode] = *iterator;
-			NoteMode current_mode = getStepNote(m_state.active_step, playing_instrument, playing_note);
-
-			bool stopped = false;
-
-			// nothing to play now
-			if (current_mode == NoteMode::Off)
-				stopped = true;
-			// it was just a press
-			else if (playing_note_mode == NoteMode::Press || playing_note_mode == NoteMode::Accent)
-				stopped = true;
-			// it was a hold but now we have a accent
-			else if (playing_note_mode == NoteMode::Hold && current_mode == NoteMode::Accent)
-				stopped = true;
-
-
-			if (stopped) {
-				//Log::d(TAG, sfmt("[%02d] Stop playing %s %s", m_state.active_step, instrumentToString(playing_instrument), noteName(playing_note)));
-				m_engine->setInstrumentNote(playing_instrument, playing_note, 0.0f);
-				erase = true;
-			}
-
-			if (erase) {
-				iterator = m_playing_notes.erase(iterator);
-			}
-			else {
-				++iterator;
-			}
-		}
-	}
-
-	void Sequencer::startPlayingNewNotes() {
-		for (auto const& current : m_steps[m_state.active_step]) {
-			auto const [step_instrument, step_note, step_note_mode] = current;
+	int Sequencer::horizon() {
+		if (m_action != Sequencer::Action::None || m_cfg_changed)
+			return 0;
 
-			auto state = getPlayingNote(step_instrument, step_note);
+		if (!m_state.playing)
+			return std::numeric_limits<int>::max();
 
+		// next step, or the end of the duty if still ahead
+		int samples = m_beat_samples - m_samples_since_last_beat;
+		if (m_samples_since_last_beat <= m_duty_samples)
+			samples = minimum(samples, m_duty_samples - m_samples_since_last_beat);
 
-			if (state == NoteMode::Off) {
-				//Log::d(TAG, sfmt("[%02d] Start playing %s %s", m_state.active_step, instrumentToString(step_instrument), noteName(step_note)));
+		return clampAbove(samples, 0);
+	}
 
-				float velocity = (step_note_mode == NoteMode::Accent) ? AccentPressVelocity : DefaultPressVelocity;
+	void Sequencer::skip(int samples) {
+		assert(samples <= horizon());
 
-				m_engine->setInstrumentNote(step_instrument, step_note, velocity);
-				m_playing_notes.push_back(current);
-			}
-			else {
+		if (m_state.playing)
+			m_samples_since_last_beat += samples;
+	}
 
-				// update playing step
-				for (size_t i = 0; i != m_playing_notes.size(); ++i)
-					if (step_instrument == std::get<0>(m_playing_notes[i]) && step_note == std::get<1>(m_playing_notes[i]))
-						m_playing_notes[i] = current;
+	Sequencer::StepGrid::Cells const& Sequencer::stepCells(InstrumentId instrument, int lane, int step) const {
+		static const StepGrid::Cells off;
+		return m_cfg->instruments[instrument].muted ? off : m_cfg->instruments[instrument].lanes[lane].step(step);
+	}
 
+	void Sequencer::stopAllPlayingNotes() {
+		for (InstrumentId instrument = InstrumentStart; instrument != InstrumentCount; ++instrument) {
+			for (int lane = 0; lane != LaneCount; ++lane) {
+				StepGrid::Cells& playing = m_playing[instrument][lane];
+				StepGrid::Cells::each(playing.active(), [&](int note) { m_engine->setInstrumentNote(instrument, note, 0.0f, lane); });
+				playing = StepGrid::Cells();
 			}
 		}
 	}
 
-	Sequencer::NoteMode Sequencer::getNote(InstrumentId instrument, int note, InstrumentNotes const& search) {
-		for (auto const& [step_instrument, step_note, step_note_mode] : search)
-			if (step_instrument == instrument && step_note == note)
-				return step_note_mode;
-
-		return Sequencer::NoteMode::Off;
-	}
-
-	Sequencer::NoteMode Sequencer::getStepNote(int step, InstrumentId instrument, int note) {
-		return getNote(instrument, note, m_steps[step]);
+	void Sequencer::stopPlayingPreviousNotes(bool duty_end) {
+		for (InstrumentId instrument = InstrumentStart; instrument != InstrumentCount; ++instrument) {
+			for (int lane = 0; lane != LaneCount; ++lane) {
+				StepGrid::Cells& playing = m_playing[instrument][lane];
+				const StepGrid::NoteBits released = playing.release(stepCells(instrument, lane, m_state.active_step));
+
+				StepGrid::Cells::each(released, [&](int note) {
+					//Log::d(TAG, sfmt("[%02d] Stop playing %s %s", m_state.active_step, instrumentToString(instrument), noteName(note)));
+					m_engine->setInstrumentNote(instrument, note, 0.0f, lane);
+				});
+			}
+		}
 	}
 
-	Sequencer::NoteMode Sequencer::getPlayingNote(InstrumentId instrument, int note) {
-		return getNote(instrument, note, m_playing_notes);
+	void Sequencer::startPlayingNewNotes() {
+		for (InstrumentId instrument = InstrumentStart; instrument != InstrumentCount; ++instrument) {
+			for (int lane = 0; lane != LaneCount; ++lane) {
+				StepGrid::Cells& playing = m_playing[instrument][lane];
+				StepGrid::Cells const& current = stepCells(instrument, lane, m_state.active_step);
+				const StepGrid::NoteBits pressed = playing.press(current);
+
+				StepGrid::Cells::each(pressed, [&](int note) {
+					//Log::d(TAG, sfmt("[%02d] Start playing %s %s", m_state.active_step, instrumentToString(instrument), noteName(note)));
+					const bool accent = current.get(note) == NoteMode::Accent;
+					m_engine->setInstrumentNote(instrument, note, accent ? AccentPressVelocity : DefaultPressVelocity, lane);
+				});
+			}
+		}
 	}
 
 	void Sequencer::panic() {
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "core/Snapshot.hpp"
 #include "audio/Audio.hpp"
 #include "instrument/Instrument.hpp"
 
@@ -29,15 +30,75 @@ namespace sns {
 			Count
 		};
 
+		// independent patterns per instrument, every TB303 instance of the rack plays its own lane
+		static constexpr int LaneCount = 4;
+
+		// longest sequence the grid and the editor accept
+		static constexpr int MaxSteps = 256;
+
+		//
+		// Step x note grid, 2 bits per cell kept as two bit planes (mode = low | high << 1)
+		// so a whole step is a few words and step transitions are word wide bit operations
+		//
+		class StepGrid {
+		public:
+			static constexpr int Words = (TotalNotes + 63) / 64;
+			using NoteBits = std::array<uint64_t, Words>;
+
+			struct Cells {
+				NoteBits low{};
+				NoteBits high{};
+
+				NoteBits active() const;	// any mode but Off
+				NoteBits holds() const;		// Hold
+				NoteBits accents() const;	// Accent
+				NoteMode get(int note) const;
+				void set(int note, NoteMode mode);
+
+				// these cells sound, moving on to next: returns the notes to release (only a hold carries on,
+				// into anything but Off or an Accent), the ones carried on are kept
+				NoteBits release(Cells const& next);
+				// returns the notes of next to press, then sounds next
+				NoteBits press(Cells const& next);
+
+				// calls f(note) for every bit set
+				template <typename F>
+				static void each(NoteBits const& notes, F f) {
+					for (int word = 0; word != Words; ++word)
+						for (uint64_t bits = notes[word]; bits; bits &= bits - 1)
+							f(word * 64 + bitIndex(bits));
+				}
+			};
+
+			NoteMode get(int step, int note) const;
+			void set(int step, int note, NoteMode mode);
+			void clear();
+			bool empty() const;
+
+			// cells of a step, all Off past the last step ever set
+			Cells const& step(int step) const;
+
+			// calls f(step, note, mode) for every cell that is not Off
+			template <typename F>
+			void each(F f) const {
+				for (int step = 0; step != int(m_steps.size()); ++step)
+					Cells::each(m_steps[step].active(), [&](int note) { f(step, note, m_steps[step].get(note)); });
+			}
+
+			static int bitIndex(uint64_t bits); // index of the lowest set bit
+		private:
+			std::vector<Cells> m_steps;
+		};
+
 		struct InstrumentConfiguration {
-			using StepNote = std::pair<int, int>; // step, note
-			using Steps = std::map<StepNote, NoteMode>;
+			using Steps = StepGrid;
 
-			Steps steps;
+			std::array<Steps, LaneCount> lanes;
 			bool muted = false;
 
 			int ui_first_row = 0;
 			int ui_first_col = 0;
+			int ui_selected_lane = 0;
 		};
 
 		struct Configuration {
@@ -54,9 +115,9 @@ namespace sns {
 			int ui_selected_instrument = InstrumentStart;
 
 
-			NoteMode stepState(InstrumentId instrument, int step, int note);
-			void setStepState(InstrumentId instrument, int step, int note, NoteMode value);
-			void toggleStepState(InstrumentId instrument, int step, int note);
+			NoteMode stepState(InstrumentId instrument, int lane, int step, int note);
+			void setStepState(InstrumentId instrument, int lane, int step, int note, NoteMode value);
+			void toggleStepState(InstrumentId instrument, int lane, int step, int note);
 		};
 
 		struct State {
@@ -76,7 +137,13 @@ namespace sns {
 		State state();
 		bool next();
 
-		void apply(Configuration const& cfg, bool chaining = false);
+		// samples after the current one during which next() would only count time
+		int horizon();
+		// counts samples without events, at most horizon()
+		void skip(int samples);
+
+		// takes a reference to the snapshot, the one it replaces is retired to the engine reclaimer
+		void apply(Snapshot<Configuration> cfg, bool chaining = false);
 		void panic();
 	private:
 		std::string TAG;
@@ -84,27 +151,23 @@ namespace sns {
 
 		State m_state;
 
-		Configuration m_cfg;
+		Snapshot<Configuration> m_cfg;
 		bool m_cfg_changed;
+		Action m_action; // pending action of m_cfg, the snapshot itself is never modified
 		int m_beat_samples;
 		int m_duty_samples;
 		int m_samples_since_last_beat;
 
 
-		// lookup data
-		using InstrumentNote = std::tuple<InstrumentId, int, NoteMode>; // instrument -> note -> notemode
-		using InstrumentNotes = std::vector<InstrumentNote>;
-		using StepNotes = std::vector<InstrumentNotes>;
-		StepNotes m_steps;
-		InstrumentNotes m_playing_notes;
+		// notes sounding per instrument and lane, with the mode of the step that last played them
+		std::array<std::array<StepGrid::Cells, LaneCount>, InstrumentCount> m_playing;
 
 		void stopAllPlayingNotes();
 		void stopPlayingPreviousNotes(bool duty_end);
 		void startPlayingNewNotes();
 
-		static NoteMode getNote(InstrumentId instrument, int note, InstrumentNotes const& search);
-		NoteMode getStepNote(int step, InstrumentId instrument, int note);
-		NoteMode getPlayingNote(InstrumentId instrument, int note);
+		// the cells to play at step, nothing for muted instruments
+		StepGrid::Cells const& stepCells(InstrumentId instrument, int lane, int step) const;
 
 	};
 
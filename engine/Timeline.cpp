@@ -0,0 +1,175 @@
+#include "Timeline.hpp"
+
+#include <algorithm>
+
+namespace sns {
+
+	Timeline::Timeline()
+		:m_length(0)
+	{
+	}
+
+	Timeline Timeline::compile(Chainer::Configuration const& cfg) {
+		using Cells = Sequencer::StepGrid::Cells;
+
+		Timeline timeline;
+		if (!cfg.valid)
+			return timeline;
+
+		uint64_t at = 0;
+
+		for (int link = 0; link != int(cfg.chain.size()); ++link) {
+			Chainer::Link const& current = cfg.chain[link];
+			if (!current.valid)
+				continue;
+
+			// same timing as the sequencer playing the link once
+			Sequencer::Configuration const& sequence = current.sequence;
+			const int step_count = sequence.step_count;
+			const int first_step = clampAbove(sequence.action_step, 0) % step_count;
+			const uint64_t beat_samples = uint64_t((SampleRate * 60) / sequence.tempo);
+			const uint64_t duty_samples = uint64_t(float(beat_samples) * sequence.duty);
+
+			auto cells = [&sequence](InstrumentId instrument, int lane, int step) -> Cells const& {
+				static const Cells off;
+				return sequence.instruments[instrument].muted ? off : sequence.instruments[instrument].lanes[lane].step(step);
+			};
+
+			for (int run = 0; run != current.runs; ++run) {
+				const size_t run_event = timeline.m_events.size();
+				std::array<std::array<Cells, Sequencer::LaneCount>, InstrumentCount> playing{};
+
+				auto release = [&timeline, &playing](uint64_t sample, auto const& next) {
+					for (InstrumentId instrument = InstrumentStart; instrument != InstrumentCount; ++instrument)
+						for (int lane = 0; lane != Sequencer::LaneCount; ++lane)
+							Cells::each(playing[instrument][lane].release(next(instrument, lane)), [&](int note) {
+								timeline.m_events.push_back({ sample, instrument, lane, note, 0.0f });
+							});
+				};
+
+				for (int step = first_step; step != step_count; ++step) {
+					const uint64_t sample = at + uint64_t(step - first_step) * beat_samples;
+					timeline.m_positions.push_back({ sample, link, run, step, timeline.m_events.size(), run_event });
+
+					auto next = [&](InstrumentId instrument, int lane) -> Cells const& { return cells(instrument, lane, step); };
+
+					release(sample, next);
+
+					for (InstrumentId instrument = InstrumentStart; instrument != InstrumentCount; ++instrument)
+						for (int lane = 0; lane != Sequencer::LaneCount; ++lane) {
+							Cells const& step_cells = next(instrument, lane);
+							Cells::each(playing[instrument][lane].press(step_cells), [&](int note) {
+								const bool accent = step_cells.get(note) == Sequencer::NoteMode::Accent;
+								timeline.m_events.push_back({ sample, instrument, lane, note, accent ? AccentPressVelocity : DefaultPressVelocity });
+							});
+						}
+
+					// the end of the duty only lets the holds carry on
+					if (duty_samples > 0 && duty_samples < beat_samples)
+						release(sample + duty_samples, next);
+				}
+
+				// the run wraps to its first step, everything is released
+				at += uint64_t(step_count - first_step) * beat_samples;
+
+				static const Cells off;
+				release(at, [](InstrumentId, int) -> Cells const& { return off; });
+
+				// the chainer starts the next run on the sample after
+				at += 1;
+			}
+		}
+
+		timeline.m_length = at;
+		return timeline;
+	}
+
+	Timeline Timeline::fromEvents(std::vector<Event> events) {
+		Timeline timeline;
+		if (events.empty())
+			return timeline;
+
+		// releases go first on a shared sample, a note released and pressed at once plays again
+		std::stable_sort(events.begin(), events.end(), [](Event const& a, Event const& b) {
+			if (a.sample != b.sample)
+				return a.sample < b.sample;
+			return (a.velocity <= 0.0f) && (b.velocity > 0.0f);
+		});
+
+		const uint64_t end = events.back().sample;
+		std::array<std::array<std::array<float, TotalNotes>, Sequencer::LaneCount>, InstrumentCount> velocities{};
+
+		timeline.m_events.reserve(events.size());
+		for (Event const& event : events) {
+			if (event.instrument < InstrumentStart || event.instrument >= InstrumentCount ||
+				event.lane < 0 || event.lane >= Sequencer::LaneCount || event.note < 0 || event.note >= TotalNotes)
+				continue;
+
+			velocities[event.instrument][event.lane][event.note] = event.velocity;
+			timeline.m_events.push_back(event);
+		}
+
+		if (timeline.m_events.empty())
+			return Timeline();
+
+		// the run ends releasing everything, as a compiled one
+		for (InstrumentId instrument = InstrumentStart; instrument != InstrumentCount; ++instrument)
+			for (int lane = 0; lane != Sequencer::LaneCount; ++lane)
+				for (int note = 0; note != TotalNotes; ++note)
+					if (velocities[instrument][lane][note] > 0.0f)
+						timeline.m_events.push_back({ end, instrument, lane, note, 0.0f });
+
+		timeline.m_positions.push_back({ 0, 0, 0, 0, 0, 0 });
+		timeline.m_length = end + 1;
+		return timeline;
+	}
+
+	bool Timeline::empty() const {
+		return m_positions.empty();
+	}
+
+	uint64_t Timeline::length() const {
+		return m_length;
+	}
+
+	std::vector<Timeline::Event> const& Timeline::events() const {
+		return m_events;
+	}
+
+	std::vector<Timeline::Position> const& Timeline::positions() const {
+		return m_positions;
+	}
+
+	size_t Timeline::seek(uint64_t sample) const {
+		auto found = std::lower_bound(m_events.begin(), m_events.end(), sample, [](Event const& event, uint64_t value) {
+			return event.sample < value;
+		});
+		return size_t(found - m_events.begin());
+	}
+
+	size_t Timeline::positionAt(uint64_t sample) const {
+		auto found = std::upper_bound(m_positions.begin(), m_positions.end(), sample, [](uint64_t value, Position const& position) {
+			return value < position.sample;
+		});
+		if (found == m_positions.begin())
+			return m_positions.size();
+		return size_t(found - m_positions.begin()) - 1;
+	}
+
+	size_t Timeline::find(int link, int step) const {
+		size_t start = m_positions.size();
+
+		for (size_t i = 0; i != m_positions.size(); ++i) {
+			Position const& position = m_positions[i];
+			if (position.link != link || position.run != 0)
+				continue;
+
+			if (start == m_positions.size())
+				start = i;
+			if (position.step == step)
+				return i;
+		}
+
+		return start;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Chainer.hpp"
+
+namespace sns {
+
+	//
+	// A chain flattened into the note events the sequencer would play, stamped with their sample
+	// from the start of the song, plus an index of every step so playback can start anywhere
+	//
+	class Timeline {
+	public:
+		struct Event {
+			uint64_t sample = 0;
+			InstrumentId instrument = InstrumentStart;
+			int lane = 0;
+			int note = 0;
+			float velocity = 0.0f; // 0 releases
+		};
+
+		// the start of a step, nothing sounds across runs (a run always ends releasing everything)
+		struct Position {
+			uint64_t sample = 0;
+			int link = 0;
+			int run = 0;
+			int step = 0;
+			size_t event = 0;		// first event at the position
+			size_t run_event = 0;	// first event of the run
+		};
+
+		Timeline();
+
+		// cfg as prepared by Chainer::prepare, every valid link played once per run in order
+		static Timeline compile(Chainer::Configuration const& cfg);
+		// free standing events (midi files) in any order, played as a single run of link 0 from step 0,
+		// notes left sounding are released on the last event
+		static Timeline fromEvents(std::vector<Event> events);
+
+		bool empty() const;
+		uint64_t length() const; // samples of one pass, looping back to 0 starts the first link again
+
+		std::vector<Event> const& events() const;
+		std::vector<Position> const& positions() const;
+
+		// index of the first event at or after sample
+		size_t seek(uint64_t sample) const;
+		// index of the last position at or before sample, positions().size() when empty
+		size_t positionAt(uint64_t sample) const;
+		// index of the position of step in the first run of link, or of the run start if the link has no such step
+		size_t find(int link, int step) const;
+
+		// calls f(event) for every note still sounding once the events up to sample (included) are played,
+		// in instrument, lane and note order
+		template <typename F>
+		void sounding(uint64_t sample, F f) const {
+			const size_t position = positionAt(sample);
+			if (position == m_positions.size())
+				return;
+
+			std::array<std::array<std::array<float, TotalNotes>, Sequencer::LaneCount>, InstrumentCount> velocities{};
+			for (size_t i = m_positions[position].run_event; i != m_events.size() && m_events[i].sample <= sample; ++i)
+				velocities[m_events[i].instrument][m_events[i].lane][m_events[i].note] = m_events[i].velocity;
+
+			for (InstrumentId instrument = InstrumentStart; instrument != InstrumentCount; ++instrument)
+				for (int lane = 0; lane != Sequencer::LaneCount; ++lane)
+					for (int note = 0; note != TotalNotes; ++note)
+						if (velocities[instrument][lane][note] > 0.0f)
+							f(Event{ sample, instrument, lane, note, velocities[instrument][lane][note] });
+		}
+	private:
+		std::vector<Event> m_events;
+		std::vector<Position> m_positions;
+		uint64_t m_length;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,80 @@
+#include "TimelineExporter.hpp"
+#include "core/Log.hpp"
+
+namespace sns {
+
+	TimelineExporter::TimelineExporter()
+		:TAG("TimelineExporter"),
+		m_format(AudioFormat::Float32),
+		m_progress(0.0f)
+	{
+	}
+
+	TimelineExporter::~TimelineExporter() {
+		stopWorking();
+	}
+
+	void TimelineExporter::startExport(Timeline timeline, TimelineRenderer::Settings const& settings, std::string const& filename, AudioFormat format) {
+		cancelExport();
+
+		m_timeline = std::move(timeline);
+		m_settings = settings;
+		m_filename = filename;
+		m_format = format;
+		m_progress = 0.0f;
+
+		startWorking();
+	}
+
+	void TimelineExporter::cancelExport() {
+		stopWorking();
+	}
+
+	bool TimelineExporter::isExporting() {
+		return isWorking();
+	}
+
+	float TimelineExporter::progress() {
+		return m_progress;
+	}
+
+	void TimelineExporter::workStep() {
+		// a single step, blocks are rendered and written in turn until done or canceled
+		const uint64_t count = m_timeline.length() + uint64_t(TailSeconds) * SampleRate;
+
+		auto writer = AudioWriter::create(m_format);
+		if (!writer->open(m_filename)) {
+			Log::e(TAG, sfmt("Unable to write %s", m_filename));
+			signalWorkEnd();
+			return;
+		}
+
+		Log::i(TAG, sfmt("Rendering %s, %d ms of audio...", m_filename, audioMilliseconds(count)));
+
+		int64_t ts = getCurrentMilliseconds();
+		std::vector<float> block(WriteBlock);
+		TimelineRenderer renderer(m_settings);
+		renderer.seek(m_timeline, 0);
+
+		for (uint64_t done = 0; done != count; ) {
+			if (!isWorking()) {
+				writer->close();
+				deleteFile(m_filename);
+				Log::i(TAG, sfmt("Canceled rendering %s", m_filename));
+				return;
+			}
+
+			const int run = int(minimum(count - done, uint64_t(WriteBlock)));
+			renderer.next(block.data(), uint64_t(run));
+			writer->write(block.data(), run);
+
+			done += uint64_t(run);
+			m_progress = float(done) / float(count);
+		}
+
+		writer->close();
+		Log::i(TAG, sfmt("Rendered %s, %d ms of audio in %d ms", m_filename, audioMilliseconds(count), getCurrentMilliseconds() - ts));
+
+		signalWorkEnd();
+	}
+}
\ No newline at end of file
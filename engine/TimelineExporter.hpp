@@ -0,0 +1,45 @@
+#pragma once
+
+#include "core/Worker.hpp"
+#include "audio/AudioWriter.hpp"
+#include "TimelineRenderer.hpp"
+
+#include <atomic>
+
+namespace sns {
+
+	//
+	// Renders a timeline to an audio file in the background, one export at a time.
+	// The result (or why it failed) is logged once done
+	//
+	class TimelineExporter : private Worker {
+	public:
+		TimelineExporter();
+		~TimelineExporter() override;
+
+		// cancels the export running, the timeline is rendered from its start with a couple of seconds for the release tails
+		void startExport(Timeline timeline, TimelineRenderer::Settings const& settings, std::string const& filename, AudioFormat format);
+		void cancelExport();
+		bool isExporting();
+
+		// fraction of the current export rendered, from 0 to 1
+		float progress();
+
+	protected:
+		void workStep() override;
+
+	private:
+		static constexpr int TailSeconds = 2;
+		static constexpr int WriteBlock = 65536; // frames rendered and written at a time
+
+		std::string TAG;
+
+		Timeline m_timeline;
+		TimelineRenderer::Settings m_settings;
+		std::string m_filename;
+		AudioFormat m_format;
+
+		std::atomic<float> m_progress;
+	};
+
+}
\ No newline at end of file
@@ -0,0 +1,108 @@
+#include "TimelineRenderer.hpp"
+#include "core/Log.hpp"
+#include "instrument/DrumMachine.hpp"
+#include "instrument/TB303.hpp"
+
+namespace sns {
+
+	TimelineRenderer::TimelineRenderer(Settings const& settings)
+		:TAG("TimelineRenderer"),
+		m_timeline(nullptr),
+		m_next(0),
+		m_position(0)
+	{
+		for (InstrumentId id = InstrumentStart; id != InstrumentCount; ++id) {
+			m_instruments[id] = createInstrument(id);
+
+			// no reclaimer, nothing renders yet so what is replaced is released right away
+			ParametersValues values = settings.values[id];
+
+			// the quality picked for live playback is not for exports, they always get the original Open303
+			if (id == InstrumentIdTB303)
+				values[ParameterQuality] = float(TB303QualityHigh);
+
+			if (!values.empty()) {
+				m_instruments[id]->takePrepared(m_instruments[id]->prepareValues(values));
+				m_instruments[id]->setValues(values);
+			}
+		}
+
+		if (!settings.drum_machine_font.empty())
+			static_cast<DrumMachine*>(m_instruments[InstrumentIdDrumMachine].get())->setSoundFont(settings.drum_machine_font);
+	}
+
+	TimelineRenderer::~TimelineRenderer() {
+
+	}
+
+	bool TimelineRenderer::render(Timeline const& timeline, uint64_t sample, uint64_t count, float* output, Progress const& progress) {
+		seek(timeline, sample);
+
+		for (uint64_t done = 0; done != count;) {
+			const uint64_t run = minimum(count - done, uint64_t(ProgressBlock));
+			next(output + done, run);
+			done += run;
+
+			if (progress && !progress(float(done) / float(count))) {
+				Log::d(TAG, sfmt("canceled after %d samples from %d", done, sample));
+				return false;
+			}
+		}
+
+		Log::d(TAG, sfmt("rendered %d samples from %d", count, sample));
+		return true;
+	}
+
+	void TimelineRenderer::seek(Timeline const& timeline, uint64_t sample) {
+		for (auto& instrument : m_instruments)
+			if (instrument)
+				instrument->panic();
+
+		const uint64_t preroll = uint64_t(PreRollSeconds) * SampleRate;
+		// on the render block grid from the song start, so block based instruments (dx7) line up with a render from 0
+		const uint64_t start = ((sample > preroll) ? sample - preroll : 0) / RenderBlock * RenderBlock;
+
+		// notes held over the start of the pre-roll are pressed again
+		timeline.sounding(start, [this](Timeline::Event const& event) {
+			m_instruments[event.instrument]->setLaneNote(event.lane, event.note, event.velocity);
+		});
+
+		m_timeline = &timeline;
+		m_next = timeline.seek(start + 1);
+		m_position = start;
+
+		advance(sample, nullptr);
+	}
+
+	void TimelineRenderer::next(float* output, uint64_t count) {
+		assert(m_timeline);
+		advance(m_position + count, output);
+	}
+
+	void TimelineRenderer::advance(uint64_t end, float* output) {
+		auto const& events = m_timeline->events();
+		const uint64_t first = m_position;
+
+		while (m_position != end) {
+			for (; m_next != events.size() && events[m_next].sample == m_position; ++m_next)
+				m_instruments[events[m_next].instrument]->setLaneNote(events[m_next].lane, events[m_next].note, events[m_next].velocity);
+
+			// up to the next event
+			uint64_t until = minimum(end, m_position + RenderBlock);
+			if (m_next != events.size())
+				until = minimum(until, events[m_next].sample);
+
+			const int run = int(until - m_position);
+			float* target = output ? output + (m_position - first) : m_preroll_block.data();
+			std::fill(target, target + run, 0.0f);
+
+			for (int i = InstrumentStart; i != InstrumentCount; ++i)
+				m_instruments[i]->render(target, run);
+
+			for (int f = 0; f != run; ++f)
+				target[f] = HardClip(target[f]);
+
+			m_position = until;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "instrument/Instrument.hpp"
+#include "Timeline.hpp"
+
+#include <functional>
+
+namespace sns {
+
+	//
+	// Renders a timeline offline through instruments of its own, set up as the live ones are.
+	// Nothing is shared with the engine, so it runs on any thread while playback goes on
+	//
+	class TimelineRenderer {
+	public:
+		struct Settings {
+			std::array<ParametersValues, InstrumentCount> values; // an instrument without values keeps its defaults
+			std::string drum_machine_font; // empty for the embedded kit
+		};
+
+		// fraction of the output rendered so far, returning false cancels the render
+		using Progress = std::function<bool(float)>;
+
+		explicit TimelineRenderer(Settings const& settings);
+		~TimelineRenderer();
+
+		// renders count samples of the timeline from sample into output, straight from the closest events after pre-rolling
+		// the last PreRollSeconds to warm the instruments up. False when canceled by progress, output is then partial
+		bool render(Timeline const& timeline, uint64_t sample, uint64_t count, float* output, Progress const& progress = Progress());
+
+		// the same render in pieces: seek pre-rolls up to sample, each next continues where the last one stopped.
+		// The timeline is not copied and must outlive them
+		void seek(Timeline const& timeline, uint64_t sample);
+		void next(float* output, uint64_t count);
+
+		//NonCopyable
+		TimelineRenderer(TimelineRenderer const&) = delete;
+		TimelineRenderer& operator=(TimelineRenderer const&) = delete;
+	private:
+		static constexpr int RenderBlock = 256; // on the grid of the engine, see render
+		static constexpr int PreRollSeconds = 4;
+		static constexpr int ProgressBlock = RenderBlock * 16; // samples between progress reports
+
+		std::string TAG;
+		std::array<std::unique_ptr<BaseInstrument>, InstrumentCount> m_instruments;
+		std::array<float, RenderBlock> m_preroll_block;
+
+		Timeline const* m_timeline;
+		size_t m_next; // next event to play
+		uint64_t m_position; // next sample to render
+
+		// renders up to end, into the scratch block and dropped when output is null
+		void advance(uint64_t end, float* output);
+	};
+}
\ No newline at end of file
@@ -20,37 +20,85 @@ namespace sns {
 	Analyser::Analyser()
 		:m_started(false)
 	{
+		for (int level = 0; level != PyramidLevels; ++level) {
+			m_partial[level] = { 0.0f, 0.0f };
+			m_partial_count[level] = 0;
+		}
+
 		configureGraph(10, 100, 0.0f, AnalyserSync::None);
 	}
 
 	void Analyser::configureGraph(int points, int duration, float offset_factor, AnalyserSync sync) {
 		m_sync = sync;
 
-		offset_factor = clampTo(offset_factor, 0.0f, 1.0f);
+		m_graph_points = clampAbove(points, 1);
+		m_graph_duration = clampTo(duration, 1, MaxGraphDuration);
+		m_graph_duration_samples = samplesFromMilliseconds(uint64_t(m_graph_duration));
+		m_graph_offset_factor = clampTo(offset_factor, 0.0f, 1.0f);
+
+		Log::d(TAG, sfmt("points=%d duration=%d offset_factor=%.2f sync=%s", 
+						 points, duration, m_graph_offset_factor, toString(sync)));
+	}
+
+	uint64_t Analyser::rangeSamples(int level) {
+		uint64_t output = PyramidBase;
+		for (int i = 0; i != level; ++i)
+			output *= PyramidFactor;
+		return output;
+	}
+
+	bool Analyser::generateGraph(std::vector<float>& minimums, std::vector<float>& maximums) {
+		if (int(minimums.size()) != m_graph_points) {
+			minimums.assign(m_graph_points, 0.0f);
+			maximums.assign(m_graph_points, 0.0f);
+		}
+
+		const uint64_t duration = m_graph_duration_samples;
+
+		// the coarsest level that still has a range (or more) per point
+		int level = -1;
+		for (int current = 0; current != PyramidLevels; ++current)
+			if (rangeSamples(current) * uint64_t(m_graph_points) <= duration)
+				level = current;
+
+		// while the history is short, a finer level that already holds a range per point draws more of it
+		while (level > 0 && m_pyramid[level].written() < uint64_t(m_graph_points))
+			level--;
+
+		uint64_t oldest = m_history.oldest();
+		uint64_t newest = m_history.written();
+		if (level >= 0) {
+			oldest = m_pyramid[level].oldest() * rangeSamples(level);
+			newest = m_pyramid[level].written() * rangeSamples(level);
+		}
 
-		m_graph_points = points;
+		// nothing received yet
+		if (newest == oldest)
+			return false;
 
-		m_graph_duration = std::min(duration, SamplesDuration);
-		m_graph_duration_samples = int(samplesFromMilliseconds(m_graph_duration));
+		// the offset moves back through the history beyond the duration, there is none while it is shorter
+		const uint64_t available = newest - oldest;
+		const uint64_t offset = (available > duration) ? uint64_t(double(available - duration) * double(m_graph_offset_factor)) : 0;
+		const int64_t start = int64_t(newest - offset) - int64_t(duration);
 
-		m_graph_offset = int(float(m_samples.capacity()) * offset_factor);
-		Log::d(TAG, sfmt("points=%d duration=%d graph_offset=%d sync=%s", 
-						 points, duration, m_graph_offset, toString(sync)));
+		if (level < 0)
+			return graphSamples(start, duration, minimums, maximums);
+		return graphRanges(level, start, duration, minimums, maximums);
 	}
 
-	void Analyser::generateGraph(std::vector<float>& points) {
-		std::unique_lock<std::mutex> lock(m_samples_mutex);
+	bool Analyser::graphSamples(int64_t start, uint64_t count, std::vector<float>& minimums, std::vector<float>& maximums) {
+		const int64_t oldest = int64_t(m_history.oldest());
+		const int64_t first = maximum(start, oldest);
 
-		if (int(points.size()) != m_graph_points)
-			points.resize(m_graph_points);
-		
-		// we still did not receive enough samples
-		if (int(m_samples.size()) < m_graph_duration_samples)
-			return;
+		// room to look back for the zero crossing
+		const uint64_t margin = (m_sync == AnalyserSync::None || start < oldest) ? 0 : minimum(uint64_t(start - oldest), uint64_t(SampleRate / 20));
+		const uint64_t held = uint64_t(start + int64_t(count) - first);
+
+		m_samples.resize(size_t(margin + held));
+		if (!m_history.read(uint64_t(first) - margin, m_samples.data(), margin + held))
+			return false;
 
-		float increment = float(m_graph_duration_samples) / float(m_graph_points);
-		int start_index = int(m_samples.size()) - m_graph_duration_samples;
-		start_index = clampAbove(start_index, 0);
+		int start_index = int(margin);
 
 		if (m_sync != AnalyserSync::None) {
 			int index = start_index;
@@ -73,35 +121,88 @@ namespace sns {
 				start_index = index;
 		}
 
+		// where the graph starts in m_samples, negative for the part that was not received yet
+		const int64_t base = int64_t(start_index) - (first - start);
+
+		for (int i = 0; i != m_graph_points; ++i) {
+			int64_t from = base + int64_t(uint64_t(i) * count / uint64_t(m_graph_points));
+			int64_t to = base + int64_t(uint64_t(i + 1) * count / uint64_t(m_graph_points));
+			to = maximum(to, from + 1);
 
-		start_index = clampAbove(start_index - m_graph_offset, 0);
+			if (to <= 0) {
+				minimums[i] = maximums[i] = 0.0f;
+				continue;
+			}
+			from = maximum(from, int64_t(0));
+
+			float low = m_samples[size_t(from)];
+			float high = low;
+			for (size_t index = size_t(from) + 1; index < size_t(to); ++index) {
+				low = minimum(low, m_samples[index]);
+				high = maximum(high, m_samples[index]);
+			}
+
+			minimums[i] = low;
+			maximums[i] = high;
+		}
+
+		return true;
+	}
+
+	bool Analyser::graphRanges(int level, int64_t start, uint64_t count, std::vector<float>& minimums, std::vector<float>& maximums) {
+		const uint64_t size = rangeSamples(level);
+		const uint64_t first = uint64_t(maximum(start, int64_t(m_pyramid[level].oldest() * size))) / size;
+		const uint64_t last = (uint64_t(start + int64_t(count)) + size - 1) / size;
+		const int64_t first_sample = int64_t(first * size);
+
+		if (last <= first)
+			return false;
+
+		m_ranges.resize(size_t(last - first));
+		if (!m_pyramid[level].read(first, m_ranges.data(), last - first))
+			return false;
 
-		
 		for (int i = 0; i != m_graph_points; ++i) {
-			float factor = float(i) * increment;
-			int point_index = int(factor);
+			const int64_t from_sample = start + int64_t(uint64_t(i) * count / uint64_t(m_graph_points));
+			const int64_t to_sample = start + int64_t(uint64_t(i + 1) * count / uint64_t(m_graph_points));
+
+			// not received yet
+			if (to_sample <= first_sample) {
+				minimums[i] = maximums[i] = 0.0f;
+				continue;
+			}
+
+			size_t from = size_t(uint64_t(maximum(from_sample, first_sample)) / size - first);
+			size_t to = size_t((uint64_t(to_sample) + size - 1) / size - first);
+			to = clampTo(to, from + 1, m_ranges.size());
 
-			points[i] = m_samples[start_index + point_index];
+			Range range = m_ranges[from];
+			for (size_t index = from + 1; index < to; ++index) {
+				range.minimum = minimum(range.minimum, m_ranges[index].minimum);
+				range.maximum = maximum(range.maximum, m_ranges[index].maximum);
+			}
+
+			minimums[i] = range.minimum;
+			maximums[i] = range.maximum;
 		}
+
+		return true;
 	}
 
-	float Analyser::peak() {
-		std::unique_lock<std::mutex> lock(m_samples_mutex);
-		constexpr int sample_count = int(samplesFromMilliseconds(150L));
-		float max = 0.0f;
+	uint64_t Analyser::written() const {
+		return m_history.written();
+	}
 
-		if (int(m_samples.size()) <= sample_count)
-			return max;
-		
-		int counter = 0;
-		while (counter != sample_count) {
-			const int index = int(m_samples.size()) - 1 - counter;
-			const float v = std::abs(m_samples[index]);
-			if (v > max)
-				max = v;
-			++counter;
+	int Analyser::latest(float* output, int count) const {
+		const uint64_t wanted = minimum(uint64_t(clampAbove(count, 0)), uint64_t(HistoryCapacity));
+
+		while (true) {
+			const uint64_t written = m_history.written();
+			const uint64_t available = minimum(written, wanted);
+
+			if (m_history.read(written - available, output, available))
+				return int(available);
 		}
-		return max;
 	}
 
 	void Analyser::start(std::string const& key) {
@@ -127,13 +228,50 @@ namespace sns {
 	bool Analyser::isAccepting() {
 		return m_started;
 	}
+
+	bool Analyser::isStartedBy(std::string const& key) const {
+		return std::find(m_keys.begin(), m_keys.end(), key) != m_keys.end();
+	}
 		
-	void Analyser::push(float sample) {
-		std::unique_lock<std::mutex> lock(m_samples_mutex);
+	void Analyser::push(float const* samples, int count) {
+		m_history.push(samples, uint64_t(count));
+
+		// fold into the min/max pyramid, a range is published as soon as it is complete
+		for (int i = 0; i != count; ++i) {
+			const float sample = samples[i];
+			Range& partial = m_partial[0];
+
+			if (m_partial_count[0] == 0) {
+				partial = { sample, sample };
+			}
+			else {
+				partial.minimum = minimum(partial.minimum, sample);
+				partial.maximum = maximum(partial.maximum, sample);
+			}
+
+			if (++m_partial_count[0] != PyramidBase)
+				continue;
+
+			for (int level = 0; level != PyramidLevels; ++level) {
+				const Range range = m_partial[level];
+				m_pyramid[level].push(&range, 1);
+				m_partial_count[level] = 0;
 
-		while (m_samples.size() == m_samples.capacity()) 
-			m_samples.pop_front();
+				if (level + 1 == PyramidLevels)
+					break;
 
-		m_samples.push_back(sample);
+				Range& next = m_partial[level + 1];
+				if (m_partial_count[level + 1] == 0) {
+					next = range;
+				}
+				else {
+					next.minimum = minimum(next.minimum, range.minimum);
+					next.maximum = maximum(next.maximum, range.maximum);
+				}
+
+				if (++m_partial_count[level + 1] != PyramidFactor)
+					break;
+			}
+		}
 	}
 }
\ No newline at end of file
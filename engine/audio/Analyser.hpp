@@ -6,7 +6,7 @@
 #include "RunningStats.hpp"
 
 #include <vector>
-#include <mutex>
+#include <atomic>
 
 namespace sns {
 
@@ -18,37 +18,70 @@ namespace sns {
 
 	class Analyser {
 	public:
+		// longest graph, covered by the coarsest level of the pyramid
+		static constexpr int MaxGraphDuration = 10 * 60 * 1000;
+
 		Analyser();
 
 		void start(std::string const& key);
 		void stop(std::string const& key);
 		bool isAccepting();
+		bool isStartedBy(std::string const& key) const;
 
-		void push(float sample);
+		// audio thread only, never blocks
+		void push(float const* samples, int count);
 
+		// duration in milliseconds, offset_factor moves the graph back in the available history
 		void configureGraph(int points, int duration, float offset_factor, AnalyserSync sync);
-		void generateGraph(std::vector<float>& points);
 
-		float peak();
+		// envelope of every point, a single sample when zoomed in. Until the duration was received
+		// the points before the oldest sample are left flat
+		bool generateGraph(std::vector<float>& minimums, std::vector<float>& maximums);
+
+		// thread safe readers of the history: total samples pushed and a copy of the most recent ones
+		uint64_t written() const;
+		int latest(float* output, int count) const;
 
 	private:
-		static constexpr int SamplesDuration = (int)audioMilliseconds(SampleRate);
 		const std::string TAG = "Analyser";
 		AnalyserSync m_sync;
 
-
 		int m_graph_points; // the number of graphed samples
 		int m_graph_duration;
-		int m_graph_duration_samples;
-		int m_graph_offset;
+		uint64_t m_graph_duration_samples;
+		float m_graph_offset_factor;
+
+		struct Range {
+			float minimum;
+			float maximum;
+		};
+
+		static constexpr size_t HistoryCapacity = 65536; // raw samples, a bit more than a second
+		static constexpr size_t PyramidCapacity = 32768; // ranges per level
+		static constexpr uint64_t PyramidBase = 16;			// samples per range of the first level
+		static constexpr uint64_t PyramidFactor = 4;		// ranges folded into the next level
+		static constexpr int PyramidLevels = 9;				// 16 samples up to 1M samples per range, a point folds a few ranges at any zoom
+
+		CircularHistory<float, HistoryCapacity> m_history;
+		std::array<CircularHistory<Range, PyramidCapacity>, PyramidLevels> m_pyramid;
+
+		// ranges being built by the writer
+		std::array<Range, PyramidLevels> m_partial;
+		std::array<uint64_t, PyramidLevels> m_partial_count;
+
+		// reader side copies
+		std::vector<float> m_samples;
+		std::vector<Range> m_ranges;
 
-		CircularBuffer<float, SampleRate> m_samples;
-		std::mutex m_samples_mutex;
+		static uint64_t rangeSamples(int level);
+		// start is negative or before the oldest sample held while the history is shorter than count
+		bool graphSamples(int64_t start, uint64_t count, std::vector<float>& minimums, std::vector<float>& maximums);
+		bool graphRanges(int level, int64_t start, uint64_t count, std::vector<float>& minimums, std::vector<float>& maximums);
 
-		bool m_started;
+		std::atomic<bool> m_started;
 		std::vector<std::string> m_keys;
 	};
 
 	std::string toString(AnalyserSync kind);
 
-}
\ No newline at end of file
+}
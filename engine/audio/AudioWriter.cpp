@@ -0,0 +1,58 @@
+#include "AudioWriter.hpp"
+#include "Wav.hpp"
+#include "Flac.hpp"
+
+namespace sns {
+
+	std::string toString(AudioFormat format) {
+		switch (format) {
+		case AudioFormat::Float32: return "WAV 32 bit float";
+		case AudioFormat::Pcm24: return "WAV 24 bit";
+		case AudioFormat::Pcm16: return "WAV 16 bit";
+		case AudioFormat::Flac24: return "FLAC 24 bit";
+		case AudioFormat::Flac16: return "FLAC 16 bit";
+		default: break;
+		}
+		return "[AudioFormat NOT_SET]";
+	}
+
+	std::string audioFormatExtension(AudioFormat format) {
+		return (format == AudioFormat::Flac24 || format == AudioFormat::Flac16) ? "flac" : "wav";
+	}
+
+	std::unique_ptr<AudioWriter> AudioWriter::create(AudioFormat format) {
+		switch (format) {
+		case AudioFormat::Pcm24: return std::make_unique<Wav>(24);
+		case AudioFormat::Pcm16: return std::make_unique<Wav>(16);
+		case AudioFormat::Flac24: return std::make_unique<Flac>(24);
+		case AudioFormat::Flac16: return std::make_unique<Flac>(16);
+		default: break;
+		}
+		return std::make_unique<Wav>(32);
+	}
+
+
+	Dither::Dither(int bits)
+		:m_scale(double(1 << (bits - 1))),
+		m_maximum((1 << (bits - 1)) - 1),
+		m_state(0x9E3779B9u)
+	{
+	}
+
+	// uniform in [0, 1), xorshift32
+	double Dither::noise() {
+		m_state ^= m_state << 13;
+		m_state ^= m_state >> 17;
+		m_state ^= m_state << 5;
+		return double(m_state) * (1.0 / 4294967296.0);
+	}
+
+	void Dither::quantize(float const* input, int32_t* output, int count) {
+		for (int i = 0; i != count; ++i) {
+			// sum of two uniform noises, +-1 lsb triangular
+			const double dithered = double(input[i]) * m_scale + (noise() - noise());
+			const int32_t value = int32_t(std::floor(dithered + 0.5));
+			output[i] = clampTo(value, -m_maximum - 1, m_maximum);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Audio.hpp"
+
+namespace sns {
+
+	enum class AudioFormat {
+		Float32,	// wav, 32 bit float
+		Pcm24,		// wav, 24 bit integer, dithered
+		Pcm16,		// wav, 16 bit integer, dithered
+		Flac24,		// flac, 24 bit, dithered
+		Flac16,		// flac, 16 bit, dithered
+
+		Count
+	};
+
+	std::string toString(AudioFormat format);
+	std::string audioFormatExtension(AudioFormat format); // "wav" or "flac"
+
+	//
+	// Streams interleaved float frames to a file, used from a single thread
+	//
+	class AudioWriter {
+	public:
+		virtual ~AudioWriter() {}
+
+		virtual bool open(std::string const& filename, int channels = 1) = 0;
+		virtual void close() = 0;
+		virtual bool isOk() = 0;
+
+		// returns the frames written
+		virtual int write(float const* data, int frames) = 0;
+
+		static std::unique_ptr<AudioWriter> create(AudioFormat format);
+	};
+
+	//
+	// Quantizes floats to signed integers of bits width with triangular (TPDF) dither
+	//
+	class Dither {
+	public:
+		explicit Dither(int bits);
+
+		void quantize(float const* input, int32_t* output, int count);
+	private:
+		double m_scale;
+		int32_t m_maximum;
+		uint32_t m_state;
+
+		double noise();
+	};
+
+}
\ No newline at end of file
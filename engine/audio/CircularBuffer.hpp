@@ -3,70 +3,207 @@
 #include "../core/Lang.hpp"
 
 #include <array>
+#include <atomic>
+#include <cassert>
 #include <cstddef>
-#include <iterator>
+#include <cstring>
+#include <type_traits>
 
 namespace sns {
 
-	template <typename T = float, int N = 2048> 
+	namespace circular {
+		constexpr bool isPowerOfTwo(size_t value) { return value != 0 && (value & (value - 1)) == 0; }
+
+		// copies count items out of / into a ring at a masked position, at most two memcpys
+		template <typename T, size_t N>
+		inline void copyOut(std::array<T, N> const& ring, uint64_t position, T* output, size_t count) {
+			const size_t offset = size_t(position & (N - 1));
+			const size_t first = minimum(count, N - offset);
+			if (first)
+				memcpy(output, ring.data() + offset, first * sizeof(T));
+			if (count > first)
+				memcpy(output + first, ring.data(), (count - first) * sizeof(T));
+		}
+
+		template <typename T, size_t N>
+		inline void copyIn(std::array<T, N>& ring, uint64_t position, T const* input, size_t count) {
+			const size_t offset = size_t(position & (N - 1));
+			const size_t first = minimum(count, N - offset);
+			if (first)
+				memcpy(ring.data() + offset, input, first * sizeof(T));
+			if (count > first)
+				memcpy(ring.data(), input + first, (count - first) * sizeof(T));
+		}
+	}
+
+	enum class CircularBufferMode {
+		SingleThread,	// plain indexes, any use from one thread
+		Spsc			// atomic indexes, one producer thread (push) and one consumer thread (read, pop_front)
+	};
+
+	//
+	// Ring with power of two capacity, indexes are free running counters masked on access
+	//
+	template <typename T = float, size_t N = 2048, CircularBufferMode Mode = CircularBufferMode::SingleThread>
 	class CircularBuffer {
 	public:
+		static_assert(circular::isPowerOfTwo(N), "CircularBuffer capacity must be a power of two");
+		static_assert(std::is_trivially_copyable_v<T>, "CircularBuffer copies items with memcpy");
+
 		using Type = T;
+		static constexpr size_t Mask = N - 1;
+		static constexpr bool Concurrent = (Mode == CircularBufferMode::Spsc);
 
 		CircularBuffer() 
-			:m_size(0), m_head(0), m_tail(0) { 
-				clear(); 
+			:m_head(0), m_tail(0) { 
 		}
 
+		CircularBuffer(CircularBuffer const&) = delete;
+		CircularBuffer& operator=(CircularBuffer const&) = delete;
+
+		// consumer side (or the only thread)
 		void clear() {
-			m_size = 0;
-			m_head = 0;
-			m_tail = 0;
+			store(m_head, load(m_tail, std::memory_order_acquire), std::memory_order_release);
 		}
 
 		void pop_front() {
 			assert(!empty());
-
-			m_head = (m_head + 1) % capacity();
-			--m_size;
+			store(m_head, load(m_head, std::memory_order_relaxed) + 1, std::memory_order_release);
 		}
 
+		// producer side, keeps the newest items: when full the front is lost (single thread only)
 		void push_back(Type v) {
-			m_data[m_tail] = v;
-			m_tail = (m_tail + 1) % capacity();
-
-			if (m_size == capacity()) {
-				// We always accept data. when full and lose the front()
-				m_head = (m_head + 1) % capacity();
-			} else {
-				++m_size;
-			}
+			static_assert(!Concurrent, "push_back overwrites the consumer side, use push");
+
+			if (size() == capacity())
+				++m_head;
+
+			m_data[m_tail & Mask] = v;
+			++m_tail;
+		}
+
+		// producer side, appends what fits and returns how many items were taken
+		size_t push(Type const* items, size_t count) {
+			const uint64_t tail = load(m_tail, std::memory_order_relaxed);
+			const uint64_t head = load(m_head, std::memory_order_acquire);
+
+			count = minimum(count, size_t(N - (tail - head)));
+			circular::copyIn(m_data, tail, items, count);
+
+			store(m_tail, tail + count, std::memory_order_release);
+			return count;
+		}
+
+		// consumer side, moves up to count items out of the buffer and returns how many were read
+		size_t read(Type* output, size_t count) {
+			const uint64_t head = load(m_head, std::memory_order_relaxed);
+			const uint64_t tail = load(m_tail, std::memory_order_acquire);
+
+			count = minimum(count, size_t(tail - head));
+			circular::copyOut(m_data, head, output, count);
+
+			store(m_head, head + count, std::memory_order_release);
+			return count;
 		}
 
 		T &operator[](int index) {
 			assert(index >= 0);
-			assert(index < size());
-			return m_data[(m_head + index) % capacity()];
+			assert(size_t(index) < size());
+			return m_data[(load(m_head, std::memory_order_relaxed) + uint64_t(index)) & Mask];
 		}
 
 		T operator[](int index) const {
 			assert(index >= 0);
-			assert(index < size());
-			return m_data[(m_head + index) % capacity()];
+			assert(size_t(index) < size());
+			return m_data[(load(m_head, std::memory_order_relaxed) + uint64_t(index)) & Mask];
 		}
 
-		bool empty() const { return m_size == 0; }
-		size_t size() const { return m_size; }
-		size_t capacity() const { return m_data.size(); }
+		bool empty() const { return size() == 0; }
+		size_t size() const { return size_t(load(m_tail, std::memory_order_acquire) - load(m_head, std::memory_order_acquire)); }
+		constexpr size_t capacity() const { return N; }
 
 		Type front() {
 			assert(!empty());
-			return m_data[m_head];
+			return m_data[load(m_head, std::memory_order_relaxed) & Mask];
 		}
 	private:
+		using Index = std::conditional_t<Concurrent, std::atomic<uint64_t>, uint64_t>;
+
+		static uint64_t load(Index const& index, std::memory_order order) {
+			if constexpr (Concurrent)
+				return index.load(order);
+			else
+				return index;
+		}
+
+		static void store(Index& index, uint64_t value, std::memory_order order) {
+			if constexpr (Concurrent)
+				index.store(value, order);
+			else
+				index = value;
+		}
+
 		std::array<Type, N> m_data;
-		size_t m_size;
-		size_t m_head;
-		size_t m_tail;
+		Index m_head; // total items consumed
+		Index m_tail; // total items produced
+	};
+
+	//
+	// Single writer history that never blocks: readers do not consume, they copy a range and
+	// check afterwards that the writer did not lap them (retrying is up to them)
+	//
+	template <typename T, size_t N>
+	class CircularHistory {
+	public:
+		static_assert(circular::isPowerOfTwo(N), "CircularHistory capacity must be a power of two");
+		static_assert(std::is_trivially_copyable_v<T>, "CircularHistory copies items with memcpy");
+
+		CircularHistory() :m_written(0), m_writing(0) {}
+
+		CircularHistory(CircularHistory const&) = delete;
+		CircularHistory& operator=(CircularHistory const&) = delete;
+
+		// writer only, overwrites the oldest items
+		void push(T const* items, uint64_t count) {
+			if (count > N) {
+				items += count - N;
+				count = N;
+			}
+
+			// the range about to be overwritten is published before the copy, so readers see it as lost
+			const uint64_t written = m_written.load(std::memory_order_relaxed);
+			m_writing.store(written + count, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+
+			circular::copyIn(m_items, written, items, size_t(count));
+			m_written.store(written + count, std::memory_order_release);
+		}
+
+		uint64_t written() const {
+			return m_written.load(std::memory_order_acquire);
+		}
+
+		// oldest position still held
+		uint64_t oldest() const {
+			const uint64_t written = this->written();
+			return written > N ? written - N : 0;
+		}
+
+		// copies [position, position + count), false when that range is not (or no longer) held
+		bool read(uint64_t position, T* output, uint64_t count) const {
+			if (count > N || position + count > written())
+				return false;
+
+			circular::copyOut(m_items, position, output, size_t(count));
+
+			// the writer may have started overwriting the start while we were copying, even if it did not finish
+			std::atomic_thread_fence(std::memory_order_acquire);
+			return m_writing.load(std::memory_order_relaxed) - position <= N;
+		}
+
+	private:
+		std::array<T, N> m_items;
+		std::atomic<uint64_t> m_written; // total items pushed
+		std::atomic<uint64_t> m_writing; // total items pushed once the push running is done, ahead of m_written during a copy
 	};
-} // namespace sns
\ No newline at end of file
+} // namespace sns
@@ -0,0 +1,414 @@
+#include "Flac.hpp"
+#include <stdio.h>
+
+// https://xiph.org/flac/format.html
+
+namespace sns {
+
+	constexpr size_t FlacFileBuffer = 1 << 20;
+	constexpr int FlacMaxPartitionOrder = 8;
+	constexpr int FlacMaxFixedOrder = 4;
+	constexpr long FlacStreamInfoOffset = 8; // "fLaC" and the metadata block header
+	constexpr int FlacStreamInfoSize = 34;
+
+	//
+	// Msb first bit packing
+	//
+	class FlacBits {
+	public:
+		void clear() {
+			m_bytes.clear();
+			m_accumulator = 0;
+			m_count = 0;
+		}
+
+		void put(uint32_t value, int bits) {
+			assert(bits <= 32);
+			if (bits == 0)
+				return;
+
+			m_accumulator = (m_accumulator << bits) | (uint64_t(value) & ((uint64_t(1) << bits) - 1));
+			m_count += bits;
+
+			while (m_count >= 8) {
+				m_count -= 8;
+				m_bytes.push_back(uint8_t(m_accumulator >> m_count));
+			}
+		}
+
+		void putSigned(int32_t value, int bits) {
+			put(uint32_t(value), bits);
+		}
+
+		void putRice(uint32_t value, int parameter) {
+			uint32_t quotient = value >> parameter;
+
+			while (quotient >= 32) {
+				put(0, 32);
+				quotient -= 32;
+			}
+
+			put(1, int(quotient) + 1);
+			put(value, parameter);
+		}
+
+		void align() {
+			if (m_count)
+				put(0, 8 - m_count);
+		}
+
+		std::vector<uint8_t> const& bytes() const { return m_bytes; }
+	private:
+		std::vector<uint8_t> m_bytes;
+		uint64_t m_accumulator = 0;
+		int m_count = 0;
+	};
+
+	static uint8_t crc8(uint8_t const* data, size_t size) {
+		uint8_t crc = 0;
+		for (size_t i = 0; i != size; ++i) {
+			crc ^= data[i];
+			for (int bit = 0; bit != 8; ++bit)
+				crc = uint8_t((crc & 0x80) ? (crc << 1) ^ 0x07 : (crc << 1));
+		}
+		return crc;
+	}
+
+	static uint16_t crc16(uint8_t const* data, size_t size) {
+		static const std::array<uint16_t, 256> table = [] {
+			std::array<uint16_t, 256> values;
+			for (int i = 0; i != 256; ++i) {
+				uint16_t crc = uint16_t(i << 8);
+				for (int bit = 0; bit != 8; ++bit)
+					crc = uint16_t((crc & 0x8000) ? (crc << 1) ^ 0x8005 : (crc << 1));
+				values[i] = crc;
+			}
+			return values;
+		}();
+
+		uint16_t crc = 0;
+		for (size_t i = 0; i != size; ++i)
+			crc = uint16_t((crc << 8) ^ table[(crc >> 8) ^ data[i]]);
+		return crc;
+	}
+
+	static int sampleRateCode(uint64_t rate) {
+		switch (rate) {
+		case 44100: return 9;
+		case 48000: return 10;
+		case 96000: return 11;
+		default: return 0; // from stream info
+		}
+	}
+
+	struct Flac::PrivateImplementation {
+		FILE* file = nullptr;
+		int bits = 16;
+		int channels = 1;
+
+		std::unique_ptr<Dither> dither;
+		std::vector<char> file_buffer;
+		std::vector<int32_t> quantized;
+		std::array<std::vector<int32_t>, MaxChannels> planar;
+		int fill = 0;
+
+		std::vector<int32_t> residual;
+		std::vector<uint32_t> folded;
+		FlacBits output;
+
+		uint32_t frame_number = 0;
+		uint64_t total_samples = 0;
+		uint32_t min_frame_size = 0;
+		uint32_t max_frame_size = 0;
+
+		void writeStreamInfo() {
+			FlacBits info;
+			info.put(BlockSize, 16);
+			info.put(BlockSize, 16);
+			info.put(min_frame_size, 24);
+			info.put(max_frame_size, 24);
+			info.put(uint32_t(sns::SampleRate), 20);
+			info.put(uint32_t(channels - 1), 3);
+			info.put(uint32_t(bits - 1), 5);
+			info.put(uint32_t(total_samples >> 32), 4);
+			info.put(uint32_t(total_samples), 32);
+			for (int i = 0; i != 4; ++i)
+				info.put(0, 32); // MD5 unknown
+
+			assert(info.bytes().size() == FlacStreamInfoSize);
+			fwrite(info.bytes().data(), info.bytes().size(), 1, file);
+		}
+
+		void putFrameNumber(uint32_t value) {
+			if (value < 0x80) {
+				output.put(value, 8);
+				return;
+			}
+
+			int length = 2;
+			while (length < 6 && value >= (1u << (5 * length + 1)))
+				++length;
+
+			output.put(((0xFF00u >> length) & 0xFF) | (value >> (6 * (length - 1))), 8);
+			for (int i = length - 2; i >= 0; --i)
+				output.put(0x80 | ((value >> (6 * i)) & 0x3F), 8);
+		}
+
+		// bits of the cheapest rice parameters for partition_order, parameters written to parameters
+		uint64_t riceCost(int count, int order, int partition_order, int max_parameter, int parameter_bits, int* parameters) {
+			const int partitions = 1 << partition_order;
+			const int partition_size = count >> partition_order;
+
+			uint64_t total = 0;
+			int start = order;
+			for (int partition = 0; partition != partitions; ++partition) {
+				const int end = (partition + 1) * partition_size;
+
+				uint64_t sum = 0;
+				for (int i = start; i != end; ++i)
+					sum += folded[i];
+
+				// sum(u >> k) <= sum >> k, so this never underestimates
+				const uint64_t samples = uint64_t(end - start);
+				uint64_t best = ~uint64_t(0);
+				for (int parameter = 0; parameter <= max_parameter; ++parameter) {
+					const uint64_t cost = samples * uint64_t(parameter + 1) + (sum >> parameter);
+					if (cost < best) {
+						best = cost;
+						parameters[partition] = parameter;
+					}
+				}
+
+				total += best + uint64_t(parameter_bits);
+				start = end;
+			}
+
+			return total;
+		}
+
+		void encodeSubframe(int32_t const* samples, int count) {
+			// constant
+			bool constant = true;
+			for (int i = 1; i != count && constant; ++i)
+				constant = (samples[i] == samples[0]);
+
+			if (constant) {
+				output.put(0, 8);
+				output.putSigned(samples[0], bits);
+				return;
+			}
+
+			// fixed predictor with the smallest residual
+			int order = 0;
+			if (count > FlacMaxFixedOrder) {
+				uint64_t sums[FlacMaxFixedOrder + 1] = {};
+				for (int i = FlacMaxFixedOrder; i != count; ++i) {
+					const int64_t e0 = samples[i];
+					const int64_t e1 = e0 - samples[i - 1];
+					const int64_t e2 = e1 - (int64_t(samples[i - 1]) - samples[i - 2]);
+					const int64_t e3 = e2 - (int64_t(samples[i - 1]) - 2 * int64_t(samples[i - 2]) + samples[i - 3]);
+					const int64_t e4 = e3 - (int64_t(samples[i - 1]) - 3 * int64_t(samples[i - 2]) + 3 * int64_t(samples[i - 3]) - samples[i - 4]);
+					sums[0] += uint64_t(absolute(e0));
+					sums[1] += uint64_t(absolute(e1));
+					sums[2] += uint64_t(absolute(e2));
+					sums[3] += uint64_t(absolute(e3));
+					sums[4] += uint64_t(absolute(e4));
+				}
+
+				for (int current = 1; current <= FlacMaxFixedOrder; ++current)
+					if (sums[current] < sums[order])
+						order = current;
+			}
+
+			for (int i = order; i != count; ++i) {
+				int64_t value = samples[i];
+				switch (order) {
+				case 1: value -= samples[i - 1]; break;
+				case 2: value += -2 * int64_t(samples[i - 1]) + samples[i - 2]; break;
+				case 3: value += -3 * int64_t(samples[i - 1]) + 3 * int64_t(samples[i - 2]) - samples[i - 3]; break;
+				case 4: value += -4 * int64_t(samples[i - 1]) + 6 * int64_t(samples[i - 2]) - 4 * int64_t(samples[i - 3]) + samples[i - 4]; break;
+				default: break;
+				}
+				residual[i] = int32_t(value);
+				folded[i] = (uint32_t(residual[i]) << 1) ^ uint32_t(residual[i] >> 31);
+			}
+
+			// rice2 (5 bit parameters) when samples are wide
+			const int method = (bits > 16) ? 1 : 0;
+			const int parameter_bits = method ? 5 : 4;
+			const int max_parameter = method ? 30 : 14;
+
+			int best_parameters[1 << FlacMaxPartitionOrder];
+			int parameters[1 << FlacMaxPartitionOrder];
+			int best_partition_order = 0;
+			uint64_t best_cost = ~uint64_t(0);
+
+			for (int partition_order = 0; partition_order <= FlacMaxPartitionOrder; ++partition_order) {
+				if ((count % (1 << partition_order)) != 0 || (count >> partition_order) <= order)
+					break;
+
+				const uint64_t cost = riceCost(count, order, partition_order, max_parameter, parameter_bits, parameters);
+				if (cost < best_cost) {
+					best_cost = cost;
+					best_partition_order = partition_order;
+					std::copy(parameters, parameters + (1 << partition_order), best_parameters);
+				}
+			}
+
+			// verbatim when prediction does not pay
+			const uint64_t predicted_bits = uint64_t(order * bits) + 6 + best_cost;
+			if (predicted_bits >= uint64_t(count) * uint64_t(bits)) {
+				output.put(1 << 1, 8);
+				for (int i = 0; i != count; ++i)
+					output.putSigned(samples[i], bits);
+				return;
+			}
+
+			output.put((8 | order) << 1, 8);
+			for (int i = 0; i != order; ++i)
+				output.putSigned(samples[i], bits);
+
+			output.put(uint32_t(method), 2);
+			output.put(uint32_t(best_partition_order), 4);
+
+			const int partition_size = count >> best_partition_order;
+			int start = order;
+			for (int partition = 0; partition != (1 << best_partition_order); ++partition) {
+				const int end = (partition + 1) * partition_size;
+				const int parameter = best_parameters[partition];
+
+				output.put(uint32_t(parameter), parameter_bits);
+				for (int i = start; i != end; ++i)
+					output.putRice(folded[i], parameter);
+
+				start = end;
+			}
+		}
+
+		void encodeFrame() {
+			const int count = fill;
+			if (count == 0)
+				return;
+
+			output.clear();
+
+			// header
+			output.put(0xFFF8, 16); // sync, fixed block size
+			output.put(count == BlockSize ? 12 : 7, 4); // 12: 4096, 7: 16 bit size at the end of the header
+			output.put(uint32_t(sampleRateCode(sns::SampleRate)), 4);
+			output.put(uint32_t(channels - 1), 4); // independent channels
+			output.put(bits == 16 ? 4 : 6, 3);
+			output.put(0, 1);
+			putFrameNumber(frame_number);
+			if (count != BlockSize)
+				output.put(uint32_t(count - 1), 16);
+			output.put(crc8(output.bytes().data(), output.bytes().size()), 8);
+
+			for (int channel = 0; channel != channels; ++channel)
+				encodeSubframe(planar[channel].data(), count);
+
+			output.align();
+			output.put(crc16(output.bytes().data(), output.bytes().size()), 16);
+
+			fwrite(output.bytes().data(), output.bytes().size(), 1, file);
+
+			const uint32_t size = uint32_t(output.bytes().size());
+			min_frame_size = (frame_number == 0) ? size : minimum(min_frame_size, size);
+			max_frame_size = maximum(max_frame_size, size);
+
+			frame_number++;
+			total_samples += uint64_t(count);
+			fill = 0;
+		}
+	};
+
+	Flac::Flac(int bits)
+		: m(std::make_shared<PrivateImplementation>()),
+		m_is_ok(false)
+	{
+		assert(bits == 16 || bits == 24);
+		m->bits = bits;
+	}
+
+	Flac::~Flac() {
+		close();
+	}
+
+	bool Flac::open(std::string const& filename, int channels) {
+		close();
+
+		m_filename = filename;
+		m_is_ok = false;
+
+		if (channels < 1 || channels > MaxChannels)
+			return false;
+
+		m->file = fopen(filename.c_str(), "wb");
+		if (m->file) {
+			m->file_buffer.resize(FlacFileBuffer);
+			setvbuf(m->file, m->file_buffer.data(), _IOFBF, m->file_buffer.size());
+
+			m->channels = channels;
+			m->dither = std::make_unique<Dither>(m->bits);
+			for (int channel = 0; channel != channels; ++channel)
+				m->planar[channel].resize(BlockSize);
+			m->residual.resize(BlockSize);
+			m->folded.resize(BlockSize);
+			m->fill = 0;
+			m->frame_number = 0;
+			m->total_samples = 0;
+			m->min_frame_size = 0;
+			m->max_frame_size = 0;
+
+			// the stream info is rewritten on close, with the sizes
+			fwrite("fLaC", 4, 1, m->file);
+			const uint8_t header[4] = { 0x80, 0, 0, FlacStreamInfoSize }; // last block, stream info
+			fwrite(header, sizeof(header), 1, m->file);
+			m->writeStreamInfo();
+
+			m_is_ok = true;
+		}
+
+		return m_is_ok;
+	}
+
+	int Flac::write(float const* data, int frames) {
+		if (!m->file || frames <= 0)
+			return 0;
+
+		const int channels = m->channels;
+		m->quantized.resize(size_t(frames) * channels);
+		m->dither->quantize(data, m->quantized.data(), frames * channels);
+
+		int32_t const* source = m->quantized.data();
+		for (int frame = 0; frame != frames; ++frame) {
+			for (int channel = 0; channel != channels; ++channel)
+				m->planar[channel][m->fill] = *source++;
+
+			if (++m->fill == BlockSize)
+				m->encodeFrame();
+		}
+
+		return frames;
+	}
+
+	void Flac::close() {
+		if (m->file) {
+			m->encodeFrame();
+
+			fseek(m->file, FlacStreamInfoOffset, SEEK_SET);
+			m->writeStreamInfo();
+
+			fclose(m->file);
+			m->file = nullptr;
+		}
+
+		m->file_buffer = std::vector<char>();
+		m_filename = "";
+		m_is_ok = false;
+	}
+
+	bool Flac::isOk() {
+		return m_is_ok;
+	}
+}
\ No newline at end of file
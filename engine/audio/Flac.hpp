@@ -0,0 +1,31 @@
+#pragma once
+
+#include "AudioWriter.hpp"
+
+namespace sns {
+
+	//
+	// Streaming flac writer: fixed block size, fixed predictors and partitioned rice residuals,
+	// dithered 16/24 bit, stream info sizes patched on close (MD5 left unset)
+	//
+	class Flac : public AudioWriter {
+	public:
+		static constexpr int BlockSize = 4096;
+		static constexpr int MaxChannels = 8;
+
+		explicit Flac(int bits = 16);
+		~Flac() override;
+
+		bool open(std::string const& filename, int channels = 1) override;
+		void close() override;
+		bool isOk() override;
+		int write(float const* data, int frames) override; // frames of interleaved channels
+	private:
+		struct PrivateImplementation;
+		std::shared_ptr<PrivateImplementation> m;
+
+		std::string m_filename;
+		bool m_is_ok;
+	};
+
+}
\ No newline at end of file
@@ -0,0 +1,230 @@
+#include "Loudness.hpp"
+
+namespace sns {
+
+	constexpr double Pi = 3.14159265358979323846;
+
+	float toLufs(double mean_square) {
+		if (mean_square <= 0.0)
+			return -INFINITY;
+		return float(-0.691 + 10.0 * log10(mean_square));
+	}
+
+	LoudnessMeter::LoudnessMeter()
+		:m_reset(false)
+	{
+		//
+		// ITU-R BS.1770 K weighting (high shelf + high pass) derived for our sample rate
+		//
+		const double rate = double(SampleRate);
+		{
+			const double f0 = 1681.974450955533;
+			const double G = 3.999843853973347;
+			const double Q = 0.7071752369554196;
+
+			const double K = tan(Pi * f0 / rate);
+			const double Vh = pow(10.0, G / 20.0);
+			const double Vb = pow(Vh, 0.4996667741545416);
+			const double a0 = 1.0 + K / Q + K * K;
+
+			m_shelf.b0 = (Vh + Vb * K / Q + K * K) / a0;
+			m_shelf.b1 = 2.0 * (K * K - Vh) / a0;
+			m_shelf.b2 = (Vh - Vb * K / Q + K * K) / a0;
+			m_shelf.a1 = 2.0 * (K * K - 1.0) / a0;
+			m_shelf.a2 = (1.0 - K / Q + K * K) / a0;
+		}
+		{
+			const double f0 = 38.13547087602444;
+			const double Q = 0.5003270373238773;
+
+			const double K = tan(Pi * f0 / rate);
+			const double a0 = 1.0 + K / Q + K * K;
+
+			m_highpass.b0 = 1.0;
+			m_highpass.b1 = -2.0;
+			m_highpass.b2 = 1.0;
+			m_highpass.a1 = 2.0 * (K * K - 1.0) / a0;
+			m_highpass.a2 = (1.0 - K / Q + K * K) / a0;
+		}
+
+		//
+		// 4x polyphase interpolator (blackman windowed sinc), every phase normalized to unity gain
+		//
+		{
+			constexpr int length = TruePeakPhases * TruePeakTaps;
+			const double center = double(length - 1) / 2.0;
+
+			for (int phase = 0; phase != TruePeakPhases; ++phase) {
+				double sum = 0.0;
+				std::array<double, TruePeakTaps> taps;
+
+				for (int j = 0; j != TruePeakTaps; ++j) {
+					const int n = j * TruePeakPhases + phase;
+					const double x = (double(n) - center) / double(TruePeakPhases);
+					const double sinc = (x == 0.0) ? 1.0 : sin(Pi * x) / (Pi * x);
+					const double w = 0.42 - 0.5 * cos(2.0 * Pi * (double(n) + 0.5) / double(length)) + 0.08 * cos(4.0 * Pi * (double(n) + 0.5) / double(length));
+					taps[j] = sinc * w;
+					sum += taps[j];
+				}
+
+				// the history is read oldest first
+				for (int j = 0; j != TruePeakTaps; ++j)
+					m_interpolator[phase][TruePeakTaps - 1 - j] = float(taps[j] / sum);
+			}
+		}
+
+		clear();
+	}
+
+	void LoudnessMeter::clear() {
+		m_shelf.z1 = m_shelf.z2 = 0.0;
+		m_highpass.z1 = m_highpass.z2 = 0.0;
+
+		m_history.fill(0.0f);
+		m_history_index = 0;
+
+		m_blocks.fill(Block());
+		m_block_index = 0;
+		m_blocks_done = 0;
+		m_current = Block();
+		m_current_samples = 0;
+
+		m_histogram_count.fill(0);
+		m_histogram_power.fill(0.0);
+		m_gated_count = 0;
+		m_gated_power = 0.0;
+
+		m_peak = 0.0f;
+		m_rms = 0.0f;
+		m_true_peak = 0.0f;
+		m_momentary = -INFINITY;
+		m_short_term = -INFINITY;
+		m_integrated = -INFINITY;
+	}
+
+	void LoudnessMeter::reset() {
+		m_reset = true;
+	}
+
+	LoudnessLevels LoudnessMeter::levels() const {
+		LoudnessLevels output;
+		output.peak = m_peak.load(std::memory_order_relaxed);
+		output.rms = m_rms.load(std::memory_order_relaxed);
+		output.true_peak = m_true_peak.load(std::memory_order_relaxed);
+		output.momentary = m_momentary.load(std::memory_order_relaxed);
+		output.short_term = m_short_term.load(std::memory_order_relaxed);
+		output.integrated = m_integrated.load(std::memory_order_relaxed);
+		return output;
+	}
+
+	void LoudnessMeter::process(float const* samples, int count) {
+		if (m_reset.exchange(false))
+			clear();
+
+		for (int i = 0; i != count; ++i) {
+			const float sample = samples[i];
+			const double weighted = m_highpass.process(m_shelf.process(double(sample)));
+
+			m_current.weighted += weighted * weighted;
+			m_current.squares += double(sample) * double(sample);
+			m_current.peak = maximum(m_current.peak, std::abs(sample));
+			m_current.true_peak = maximum(m_current.true_peak, truePeak(sample));
+
+			if (++m_current_samples == BlockSamples)
+				completeBlock();
+		}
+
+		publish();
+	}
+
+	float LoudnessMeter::truePeak(float sample) {
+		m_history[m_history_index] = sample;
+		m_history[m_history_index + TruePeakTaps] = sample;
+		m_history_index = (m_history_index + 1) % TruePeakTaps;
+
+		float const* history = m_history.data() + m_history_index;
+		float peak = std::abs(sample);
+
+		for (auto const& taps : m_interpolator) {
+			float value = 0.0f;
+			for (int j = 0; j != TruePeakTaps; ++j)
+				value += taps[j] * history[j];
+			peak = maximum(peak, std::abs(value));
+		}
+
+		return peak;
+	}
+
+	void LoudnessMeter::completeBlock() {
+		m_block_index = (m_block_index + 1) % BlockCount;
+		m_blocks[m_block_index] = m_current;
+		m_blocks_done++;
+
+		m_current = Block();
+		m_current_samples = 0;
+
+		// a new 400 ms block every 100 ms (75% overlap) feeds the gated measurement
+		if (m_blocks_done >= MomentaryBlocks) {
+			const double power = windowPower(MomentaryBlocks);
+			const float lufs = toLufs(power);
+
+			if (lufs >= HistogramMinimum) {
+				const int bin = clampTo(int((lufs - HistogramMinimum) * 10.0f), 0, HistogramSize - 1);
+				m_histogram_count[bin]++;
+				m_histogram_power[bin] += power;
+
+				m_gated_count++;
+				m_gated_power += power;
+			}
+			m_momentary = lufs;
+		}
+
+		m_short_term = toLufs(windowPower(BlockCount));
+		m_integrated = integrated();
+	}
+
+	double LoudnessMeter::windowPower(int blocks) const {
+		blocks = minimum(blocks, m_blocks_done);
+		if (blocks == 0)
+			return 0.0;
+
+		double sum = 0.0;
+		for (int i = 0; i != blocks; ++i)
+			sum += m_blocks[(m_block_index - i + BlockCount) % BlockCount].weighted;
+
+		return sum / double(blocks * BlockSamples);
+	}
+
+	float LoudnessMeter::integrated() const {
+		if (m_gated_count == 0)
+			return -INFINITY;
+
+		// relative gate, 10 LU below the loudness of the blocks above the absolute gate
+		const float relative = toLufs(m_gated_power / double(m_gated_count)) - 10.0f;
+		const int first = clampTo(int((relative - HistogramMinimum) * 10.0f), 0, HistogramSize - 1);
+
+		uint64_t count = 0;
+		double power = 0.0;
+		for (int bin = first; bin != HistogramSize; ++bin) {
+			count += m_histogram_count[bin];
+			power += m_histogram_power[bin];
+		}
+
+		return count ? toLufs(power / double(count)) : -INFINITY;
+	}
+
+	void LoudnessMeter::publish() {
+		Block const& last = m_blocks[m_block_index];
+
+		double squares = m_current.squares;
+		int samples = m_current_samples;
+		for (int i = 0; i != minimum(RmsBlocks, m_blocks_done); ++i) {
+			squares += m_blocks[(m_block_index - i + BlockCount) % BlockCount].squares;
+			samples += BlockSamples;
+		}
+
+		m_peak.store(maximum(m_current.peak, last.peak), std::memory_order_relaxed);
+		m_true_peak.store(maximum(m_current.true_peak, last.true_peak), std::memory_order_relaxed);
+		m_rms.store(samples ? float(std::sqrt(squares / double(samples))) : 0.0f, std::memory_order_relaxed);
+	}
+}
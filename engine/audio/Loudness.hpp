@@ -0,0 +1,105 @@
+#pragma once
+
+#include "../core/Lang.hpp"
+#include "Audio.hpp"
+
+#include <atomic>
+
+namespace sns {
+
+	struct LoudnessLevels {
+		float peak = 0.0f;			// linear, sample peak over the last ~150 ms
+		float rms = 0.0f;			// linear, over the last 300 ms
+		float true_peak = 0.0f;		// linear, 4x oversampled peak over the last ~150 ms
+		float momentary = -INFINITY;	// LUFS, 400 ms window
+		float short_term = -INFINITY;	// LUFS, 3 s window
+		float integrated = -INFINITY;	// LUFS, gated (EBU R128) since the last reset
+	};
+
+	//
+	// Incremental meters fed with whole blocks on the audio thread, the results are published as atomics
+	// so any thread can read them without touching the sample history
+	//
+	class LoudnessMeter {
+	public:
+		LoudnessMeter();
+
+		// audio thread only
+		void process(float const* samples, int count);
+
+		// any thread
+		LoudnessLevels levels() const;
+		void reset(); // restarts the integrated measurement (applied on the next process)
+
+	private:
+		static constexpr int BlockSamples = int(SampleRate / 10);	// 100 ms, the R128 step
+		static constexpr int BlockCount = 30;						// 3 s, the short term window
+		static constexpr int MomentaryBlocks = 4;					// 400 ms
+		static constexpr int RmsBlocks = 3;							// 300 ms
+
+		static constexpr int TruePeakPhases = 4;
+		static constexpr int TruePeakTaps = 12; // per phase
+
+		// integrated loudness histogram, 0.1 LU steps from the absolute gate up
+		static constexpr float HistogramMinimum = -70.0f;
+		static constexpr float HistogramMaximum = 10.0f;
+		static constexpr int HistogramSize = int((HistogramMaximum - HistogramMinimum) * 10.0f);
+
+		struct Biquad {
+			double b0 = 1.0, b1 = 0.0, b2 = 0.0, a1 = 0.0, a2 = 0.0;
+			double z1 = 0.0, z2 = 0.0;
+
+			double process(double in) {
+				double out = b0 * in + z1;
+				z1 = b1 * in - a1 * out + z2;
+				z2 = b2 * in - a2 * out;
+				return out;
+			}
+		};
+
+		struct Block {
+			double weighted = 0.0;	// sum of squares of the K weighted signal
+			double squares = 0.0;	// sum of squares of the signal
+			float peak = 0.0f;
+			float true_peak = 0.0f;
+		};
+
+		// K weighting
+		Biquad m_shelf;
+		Biquad m_highpass;
+
+		// 4x interpolation for the true peak
+		std::array<std::array<float, TruePeakTaps>, TruePeakPhases> m_interpolator;
+		std::array<float, TruePeakTaps * 2> m_history; // doubled so the taps always read contiguous samples
+		int m_history_index;
+
+		std::array<Block, BlockCount> m_blocks;
+		int m_block_index;		// last completed block
+		int m_blocks_done;
+		Block m_current;
+		int m_current_samples;
+
+		std::array<uint32_t, HistogramSize> m_histogram_count;
+		std::array<double, HistogramSize> m_histogram_power;
+		uint64_t m_gated_count;
+		double m_gated_power;
+
+		std::atomic<bool> m_reset;
+		std::atomic<float> m_peak;
+		std::atomic<float> m_rms;
+		std::atomic<float> m_true_peak;
+		std::atomic<float> m_momentary;
+		std::atomic<float> m_short_term;
+		std::atomic<float> m_integrated;
+
+		void clear();
+		float truePeak(float sample);
+		void completeBlock();
+		double windowPower(int blocks) const;
+		float integrated() const;
+		void publish();
+	};
+
+	// loudness from a mean square of K weighted samples
+	float toLufs(double mean_square);
+}
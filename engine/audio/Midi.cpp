@@ -1,4 +1,6 @@
 #include "Midi.hpp"
+#include "CircularBuffer.hpp"
+#include "MidiClock.hpp"
 #include "../core/Log.hpp"
 
 #define LIBREMIDI_HEADER_ONLY 1
@@ -37,6 +39,25 @@ namespace sns {
 			current.channel = -1;
 	}
 
+	//
+	// What one input hands over to the audio thread, its libremidi callback is the only producer and
+	// Midi::take the only consumer
+	//
+	struct MidiPortQueue {
+		std::string name; // set before the port opens, cleared after it closes
+		MidiPortClock clock; // callback
+
+		CircularBuffer<MidiMessage, Midi::QueueSize, CircularBufferMode::Spsc> messages;
+
+		// sysex arena, slots are filled in order and given back when the take after the one playing them starts
+		std::array<std::array<uint8_t, Midi::SysexSize>, Midi::SysexSlots> sysex;
+		std::array<std::array<Prepared, InstrumentCount>, Midi::SysexSlots> sysex_prepared; // callback, replaced with the slot
+		uint64_t sysex_written = 0;					// callback
+		std::atomic<uint64_t> sysex_released{ 0 };	// take
+		uint64_t sysex_played = 0;					// played
+		uint8_t const* sysex_last = nullptr;		// played
+	};
+
 	struct Midi::PrivateImplementation
 	{
 		Midi::Mapping active_mapping;
@@ -47,9 +68,10 @@ namespace sns {
 		bool needs_dump_info = true;
 
 		InstrumentId active_instrument = 0;
+		Midi::SysexPreparer sysex_preparer;
 
 		std::vector<std::string> available_ports;
-		MidiMessages messages;
+		std::array<MidiPortQueue, MaxPorts> queues;
 
 		std::mutex mutex;
 
@@ -86,15 +108,31 @@ namespace sns {
 		m->active_instrument = instrument;
 	}
 
-	MidiMessages Midi::take() {
-		MidiMessages messages;
+	void Midi::setSysexPreparer(SysexPreparer preparer) {
+		m->sysex_preparer = std::move(preparer);
+	}
 
-		{
-			std::unique_lock<std::mutex> lock(m->mutex);
-			std::swap(messages, m->messages);
+	size_t Midi::take(MidiMessage* messages, size_t count) {
+		size_t taken = 0;
+
+		for (auto& queue : m->queues) {
+			// the caller is done with the sysex it played since last time
+			queue.sysex_released.store(queue.sysex_played, std::memory_order_release);
+
+			taken += queue.messages.read(messages + taken, count - taken);
 		}
 
-		return messages;
+		return taken;
+	}
+
+	void Midi::played(MidiMessage const& message) {
+		MidiPortQueue& queue = m->queues[message.port];
+
+		// a sysex is queued once per instrument it goes to, its slot is counted once
+		if (message.sysex && message.sysex != queue.sysex_last) {
+			queue.sysex_last = message.sysex;
+			queue.sysex_played++;
+		}
 	}
 
 	std::vector<std::string> Midi::ports() {
@@ -102,6 +140,11 @@ namespace sns {
 		return m->available_ports;
 	}
 
+	std::string Midi::portName(int port) {
+		std::unique_lock<std::mutex> lock(m->mutex);
+		return (port >= 0 && port < MaxPorts) ? m->queues[port].name : std::string();
+	}
+
 	void Midi::preWork() {
 		midiTeardown();
 		m->midi_in_helper = std::make_shared<libremidi::midi_in>();
@@ -172,6 +215,12 @@ namespace sns {
 		midiTeardown();
 
 		for (auto const& port_name : ports) {
+			const int index = int(m->in.size());
+			if (index == MaxPorts) {
+				Log::e(TAG, sfmt("Only %d ports are opened, ignoring [%s]", MaxPorts, port_name));
+				break;
+			}
+
 			auto in = std::make_shared<libremidi::midi_in>();
 			int port = -1;
 
@@ -189,19 +238,20 @@ namespace sns {
 				continue;
 			}
 
+			{
+				std::unique_lock<std::mutex> lock(m->mutex);
+				m->queues[index].name = port_name;
+			}
+			m->queues[index].clock.reset();
+
 			in->open_port(port);
 
 			in->set_error_callback([this, port](libremidi::midi_error type, std::string_view errorText) {
 				Log::e(TAG, sfmt("Port [%d] error [%d/%s]", port, int(type), errorText));
 				});
 
-			in->set_callback([this, port_name](const libremidi::message& message) {
-				MidiMessage data;
-				data.port = port_name;
-				data.timestamp = message.timestamp;
-				data.bytes = message.bytes;
-				data.parameter = ParameterNone;
-				midiReceived(data);
+			in->set_callback([this, index](const libremidi::message& message) {
+				midiReceived(index, message.bytes.data(), message.bytes.size(), message.timestamp);
 				});
 
 			m->in.push_back(in);
@@ -209,68 +259,112 @@ namespace sns {
 		}
 	}
 
-	void Midi::midiReceived(MidiMessage& message) {
+	void Midi::midiReceived(int port, uint8_t const* bytes, size_t size, double timestamp) {
 
-		if (message.bytes.empty())
+		if (size == 0)
 			return;
 
-		uint8_t cmd = message.bytes[0];
+		MidiPortQueue& queue = m->queues[port];
+
+		MidiMessage message;
+		message.port = uint16_t(port);
+		message.timestamp = queue.clock.map(timestamp, double(getCurrentMicroseconds()) / double(Microseconds));
+		message.parameter = ParameterNone;
+
+		if (bytes[0] == 0xf0) {
+			// sysex, into the next arena slot once the audio thread gave it back
+			const uint64_t released = queue.sysex_released.load(std::memory_order_acquire);
+			if (size > size_t(SysexSize) || queue.sysex_written - released == uint64_t(SysexSlots)) {
+				Log::e(TAG, sfmt("[%s] dropped sysex of %d bytes", queue.name, int(size)));
+				return;
+			}
+
+			auto& slot = queue.sysex[queue.sysex_written % SysexSlots];
+			memcpy(slot.data(), bytes, size);
+			message.sysex = slot.data();
+			message.sysex_size = uint32_t(size);
+		}
+		else {
+			message.bytes_size = uint8_t(minimum(size, size_t(MidiMessage::InlineBytes)));
+			memcpy(message.bytes.data(), bytes, message.bytes_size);
+		}
+
+		uint8_t cmd = bytes[0];
 		uint8_t type = cmd & 0xf0;
 		int channel = int(cmd & 0x0f);
 
 		int cc = -1000;
 		float value = 0.0f;
 
-		if (message.bytes.size() >= 3) {
+		if (size >= 3) {
 			if (type == 0xb0) {
 				// controller
-				cc = message.bytes[1];
-				value = float(clampTo(int(message.bytes[2]), 0, 127) / 127.0f);
+				cc = bytes[1];
+				value = float(clampTo(int(bytes[2]), 0, 127) / 127.0f);
 			}
 			else if (cmd == 0xe0) {
 				// pitch bend
 				cc = -1;
-				int v = message.bytes[1] | (message.bytes[2] << 7);
+				int v = bytes[1] | (bytes[2] << 7);
 				value = clampTo(float(v - 8192) / float(8192), -1.0f, 1.0f);
 			}
 		}
 
-		//Log::d(TAG, sfmt("[%s] cmd=0x%02X channel=0x%X", message.port, cmd, channel));
+		bool queued = false;
+
+		//Log::d(TAG, sfmt("[%s] cmd=0x%02X channel=0x%X", queue.name, cmd, channel));
 		for (int i = InstrumentStart; i != int(m->active_mapping.instruments.size()); ++i) {
 			if (m->active_mapping.filter_active_instrument && i != m->active_instrument)
 				continue;
 
-			bool same_port = (m->active_mapping.instruments[i].port == message.port);
+			bool same_port = (m->active_mapping.instruments[i].port == queue.name);
 			bool same_channel = (m->active_mapping.instruments[i].channel == -1) ||
 				(m->active_mapping.instruments[i].channel == channel);
 
 			if (same_port && same_channel) {
-				message.instrument = i;
+				MidiMessage current = message;
+				current.instrument = i;
 
 				if (cc >= 0) {
 					auto found = m->active_mapping.instruments[i].cc.find(cc);
 					if (found != m->active_mapping.instruments[i].cc.end()) {
-						message.parameter = found->second;
-						message.parameter_value = value;
+						current.parameter = found->second;
+						current.parameter_value = value;
 					}
 				}
 				else if (cc == -1) {
 					// pitch bend
-					message.parameter = ParameterPitchBend;
-					message.parameter_value = value;
+					current.parameter = ParameterPitchBend;
+					current.parameter_value = value;
 				}
 
-				{
-					std::unique_lock<std::mutex> lock(m->mutex);
-					m->messages.push_back(message);
+				if (message.sysex && m->sysex_preparer) {
+					// what the slot held before is released here, the audio thread gave it back
+					Prepared& prepared = queue.sysex_prepared[queue.sysex_written % SysexSlots][i];
+					prepared = m->sysex_preparer(i, bytes, size);
+					current.prepared = &prepared;
 				}
+
+				if (queue.messages.push(&current, 1) == 1)
+					queued = true;
+				else
+					Log::e(TAG, sfmt("[%s] queue full, dropped message", queue.name));
 			}
 		}
+
+		// the slot stays free when nothing refers to it
+		if (message.sysex && queued)
+			queue.sysex_written++;
 	}
 
 	void Midi::midiTeardown() {
+		// closing the ports stops their callbacks, what they queued is still taken
 		m->in.clear();
 		m->in_names.clear();
+
+		std::unique_lock<std::mutex> lock(m->mutex);
+		for (auto& queue : m->queues)
+			queue.name.clear();
 	}
 
 	void Midi::midiEnumerate() {
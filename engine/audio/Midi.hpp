@@ -33,8 +33,26 @@ namespace sns {
 		void setMapping(Mapping const& mapping);
 		void setActiveInstrument(InstrumentId instrument);
 
+		// called on the port callback thread for each instrument a sysex goes to, what it returns comes with
+		// the message (MidiMessage::prepared), set before the worker starts
+		using SysexPreparer = std::function<Prepared(InstrumentId instrument, uint8_t const* data, size_t size)>;
+		void setSysexPreparer(SysexPreparer preparer);
+
 		std::vector<std::string> ports();
-		MidiMessages take();
+		std::string portName(int port); // name of an interned MidiMessage::port
+
+		static constexpr int MaxPorts = 8;
+		static constexpr int QueueSize = 1024; // messages waiting per port
+		static constexpr int SysexSlots = 4;
+		static constexpr int SysexSize = 8192; // fits a dx7 32 voice bank dump (4104 bytes)
+
+		// audio thread, lock free: moves up to count waiting messages into messages and returns how many,
+		// the sysex of the messages played since the previous take are given back to their arena
+		size_t take(MidiMessage* messages, size_t count);
+
+		// audio thread, a message taken was handed to its instrument. Its sysex (if any) stays valid until
+		// the next take, a port's messages are played in the order taken
+		void played(MidiMessage const& message);
 
 	protected:
 		void preWork() override;
@@ -52,7 +70,7 @@ namespace sns {
 
 		void midiEnumerate();
 		void midiDumpInfo();
-		void midiReceived(MidiMessage& message);
+		void midiReceived(int port, uint8_t const* bytes, size_t size, double timestamp);
 	};
 
 }
\ No newline at end of file
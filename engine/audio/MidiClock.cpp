@@ -0,0 +1,68 @@
+#include "MidiClock.hpp"
+
+namespace sns {
+
+	constexpr double DriftGain = 0.001;		// share of a slower arrival taken into the port offset
+	constexpr double SteerGain = 0.05;		// share of the block start error corrected each block
+	constexpr double ResyncSeconds = 0.25;	// further off than this is a restart (device reset, audio stall)
+
+	MidiPortClock::MidiPortClock() {
+		reset();
+	}
+
+	void MidiPortClock::reset() {
+		m_started = false;
+		m_device = 0.0;
+		m_offset = 0.0;
+	}
+
+	double MidiPortClock::map(double delta, double arrival) {
+		if (!m_started || delta < 0.0) {
+			m_started = true;
+			m_device = 0.0;
+			m_offset = arrival;
+			return arrival;
+		}
+
+		m_device += delta;
+
+		const double offset = arrival - m_device;
+		if (offset < m_offset || offset - m_offset > ResyncSeconds)
+			m_offset = offset;
+		else
+			m_offset += (offset - m_offset) * DriftGain;
+
+		return minimum(m_device + m_offset, arrival);
+	}
+
+	SampleClock::SampleClock() {
+		reset();
+	}
+
+	void SampleClock::reset() {
+		m_started = false;
+		m_sample = 0;
+		m_time = 0.0;
+	}
+
+	void SampleClock::update(uint64_t sample, double now) {
+		const double predicted = m_time + double(sample - m_sample) / double(SampleRate);
+		const double error = now - predicted;
+
+		m_sample = sample;
+
+		if (!m_started || absolute(error) > ResyncSeconds) {
+			m_started = true;
+			m_time = now;
+			return;
+		}
+
+		m_time = predicted + error * SteerGain;
+	}
+
+	double SampleClock::sampleAt(double time) const {
+		if (!m_started)
+			return 0.0;
+		return double(m_sample) + (time - m_time) * double(SampleRate);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Audio.hpp"
+
+namespace sns {
+
+	//
+	// Message times of one port on the host clock (getCurrentMicroseconds, in seconds). libremidi stamps
+	// each message with the device time since the previous one, their sum runs the device clock and its
+	// offset to the host clock is the fastest arrival seen, let go slowly to follow the clocks drifting apart
+	//
+	class MidiPortClock {
+	public:
+		MidiPortClock();
+
+		void reset();
+
+		// host time the message was sent at, never after its arrival
+		double map(double delta, double arrival);
+	private:
+		bool m_started;
+		double m_device;	// device time of the last message
+		double m_offset;	// host time at device time 0
+	};
+
+	//
+	// The engine sample counter on the host clock. Blocks start with the jitter of the audio callback,
+	// their times steer a clock running at the sample rate instead of being used as they are
+	//
+	class SampleClock {
+	public:
+		SampleClock();
+
+		void reset();
+
+		// a block starting at sample is being produced at now
+		void update(uint64_t sample, double now);
+
+		// sample produced at the host time, before the first update everything is at 0
+		double sampleAt(double time) const;
+	private:
+		bool m_started;
+		uint64_t m_sample;
+		double m_time;		// host time of m_sample
+	};
+}
\ No newline at end of file
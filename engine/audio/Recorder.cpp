@@ -5,22 +5,48 @@ namespace sns {
 
 	Recorder::Recorder()
 		:TAG("Recorder"),
-		m_accepting(false),
-		m_flush_size(1024 * 10),
-		m_received_samples(0)
+		m_ring(std::make_unique<Ring>()),
+		m_chunk(ChunkSize),
+		m_track_chunk(ChunkSize),
+		m_received_samples(0),
+		m_dropped_samples(0),
+		m_reported_dropped_samples(0),
+		m_format(AudioFormat::Float32),
+		m_layout(RecordingLayout::Mix),
+		m_tracks(1),
+		m_accepting(false)
 	{
-
-		setSleepMs(500);
+		// the audio thread does not signal, the ring holds many times this period
+		setSleepMs(100);
 	}
 
 	Recorder::~Recorder() {
-
+		stopWorking();
 	}
 
-	void Recorder::startRecording(std::string const& filename) {
+	void Recorder::startRecording(std::string const& filename, RecordingLayout layout, std::vector<std::string> const& stems) {
 		stopRecording();
 		m_received_samples = 0;
-		m_filename = filename;
+		m_dropped_samples = 0;
+		m_reported_dropped_samples = 0;
+
+		m_layout = stems.empty() ? RecordingLayout::Mix : layout;
+		m_tracks = (m_layout == RecordingLayout::Mix) ? 1 : clampBelow(1 + int(stems.size()), MaxTracks);
+
+		m_filenames.clear();
+		if (m_layout == RecordingLayout::Files) {
+			// name.wav becomes name-master.wav, name-<stem>.wav...
+			const std::string base = getNameLessExtension(filename);
+			const std::string extension = audioFormatExtension(m_format);
+
+			m_filenames.push_back(sfmt("%s-master.%s", base, extension));
+			for (int track = 1; track != m_tracks; ++track)
+				m_filenames.push_back(sfmt("%s-%s.%s", base, sanitizeName(stems[track - 1], false), extension));
+		}
+		else {
+			m_filenames.push_back(filename);
+		}
+
 		startWorking();
 	}
 
@@ -33,24 +59,44 @@ namespace sns {
 		return isWorking();
 	}
 
+	void Recorder::setFormat(AudioFormat format) {
+		m_format = format;
+	}
+
+	AudioFormat Recorder::format() {
+		return m_format;
+	}
+
 	uint64_t Recorder::recordedMilliseconds() {
 		return audioMilliseconds(m_received_samples);
 	}
 
+	uint64_t Recorder::droppedSamples() {
+		return m_dropped_samples;
+	}
+
 	bool Recorder::isAccepting() {
 		return isWorking() && m_accepting;
 	}
 
-	void Recorder::push(float sample) {
-		if (m_accepting) {
-			std::unique_lock<std::mutex> lock(m_mutex);
+	int Recorder::tracks() {
+		return m_tracks;
+	}
+
+	void Recorder::push(float const* frames, int count) {
+		if (!m_accepting || count <= 0)
+			return;
 
-			m_write.push_back(sample);
-			m_received_samples += 1;
+		// whole frames only, so the writer never sees the tracks shifted
+		const size_t tracks = size_t(m_tracks.load(std::memory_order_relaxed));
+		const size_t room = (m_ring->capacity() - m_ring->size()) / tracks;
+		const size_t accepted = minimum(size_t(count), room);
 
-			if (m_write.size() > m_flush_size)
-				signalWorkArrived();
-		}
+		m_ring->push(frames, accepted * tracks);
+
+		m_received_samples.fetch_add(accepted, std::memory_order_relaxed);
+		if (accepted != size_t(count))
+			m_dropped_samples.fetch_add(size_t(count) - accepted, std::memory_order_relaxed);
 	}
 
 	void Recorder::workStep() {
@@ -58,36 +104,64 @@ namespace sns {
 	}
 
 	void Recorder::preWork() {
-		sns::makeDirectoryForFile(m_filename);
+		// leftovers of a previous recording, nobody is pushing
+		m_ring->clear();
 
-		Log::i(TAG, sfmt("Starting recorder (%s)...", m_filename));
-		m_accepting = m_output.open(m_filename);
+		const int channels = (m_layout == RecordingLayout::Interleaved) ? m_tracks.load() : 1;
 
-		if (!m_accepting) {
-			Log::e(TAG, sfmt("Failed to start output to (%s)", m_filename));
+		bool ok = true;
+		m_outputs.clear();
+		for (size_t output = 0; output != m_filenames.size() && ok; ++output) {
+			sns::makeDirectoryForFile(m_filenames[output]);
+
+			Log::i(TAG, sfmt("Starting recorder (%s, %s, %d channels)...", m_filenames[output], toString(m_format), channels));
+			m_outputs.push_back(AudioWriter::create(m_format));
+			ok = m_outputs.back()->open(m_filenames[output], channels);
+
+			if (!ok) {
+				Log::e(TAG, sfmt("Failed to start output to (%s)", m_filenames[output]));
+			}
 		}
+
+		m_accepting = ok;
 	}
 
 	void Recorder::postWork() {
 		m_accepting = false;
 
 		writeToFile();
-		m_output.close();
+		for (auto& output : m_outputs)
+			output->close();
+		m_outputs.clear();
 
 		Log::i(TAG, "Stopped recorder...");
 	}
 
 	void Recorder::writeToFile() {
-		m_read.clear();
+		const size_t tracks = size_t(m_tracks.load());
+		const size_t wanted = (m_chunk.size() / tracks) * tracks;
+
+		size_t read;
+		while ((read = m_ring->read(m_chunk.data(), wanted)) != 0) {
+			const int frames = int(read / tracks);
+
+			if (m_layout != RecordingLayout::Files) {
+				m_outputs[0]->write(m_chunk.data(), frames);
+				continue;
+			}
+
+			for (size_t track = 0; track != tracks; ++track) {
+				for (int frame = 0; frame != frames; ++frame)
+					m_track_chunk[frame] = m_chunk[frame * tracks + track];
 
-		{
-			std::unique_lock<std::mutex> lock(m_mutex);
-			std::swap(m_write, m_read);
+				m_outputs[track]->write(m_track_chunk.data(), frames);
+			}
 		}
 
-		if (!m_read.empty()) {
-			//Log::e(TAG, sfmt("About to save %d samples", m_read.size()));
-			m_output.write(m_read.data(), (int)m_read.size());
+		const uint64_t dropped = m_dropped_samples;
+		if (dropped != m_reported_dropped_samples) {
+			Log::e(TAG, sfmt("Recorder overflow, %d frames lost so far", dropped));
+			m_reported_dropped_samples = dropped;
 		}
 	}
 }
\ No newline at end of file
@@ -1,23 +1,48 @@
 #pragma once
 
 #include "../core/Worker.hpp"
-#include "Wav.hpp"
+#include "CircularBuffer.hpp"
+#include "AudioWriter.hpp"
+
+#include <atomic>
 
 namespace sns {
 
+	enum class RecordingLayout {
+		Mix,		// the master only
+		Interleaved,	// master and stems as the channels of one file
+		Files		// master and stems each in its own file
+	};
+
 	class Recorder : private Worker {
 	public:
+		static constexpr int MaxTracks = 16;
+
 		Recorder();
 		~Recorder() override;
 
-		void startRecording(std::string const& filename);
+		// stems name the tracks recorded next to the master, ignored when recording the mix
+		void startRecording(std::string const& filename, RecordingLayout layout = RecordingLayout::Mix, 
+			std::vector<std::string> const& stems = {});
 		void stopRecording();
 		bool isRecording();
 
+		// file format of the next recordings
+		void setFormat(AudioFormat format);
+		AudioFormat format();
+
 		uint64_t recordedMilliseconds();
 
+		// samples lost because the writer fell behind, since the recording started
+		uint64_t droppedSamples();
+
 		bool isAccepting();
-		void push(float sample);
+
+		// channels of each pushed frame, the master first then the stems
+		int tracks();
+
+		// audio thread, never blocks nor allocates, frames hold tracks() interleaved samples
+		void push(float const* frames, int count);
 
 	protected:
 		void workStep() override;
@@ -25,17 +50,26 @@ namespace sns {
 		void postWork() override;
 
 	private:
+		static constexpr size_t RingCapacity = 1 << 19; // samples, almost 12 seconds of mix
+		static constexpr size_t ChunkSize = 1 << 14;	 // samples written to file at once
+
+		using Ring = CircularBuffer<float, RingCapacity, CircularBufferMode::Spsc>;
+
 		std::string TAG;
 
-		std::mutex m_mutex;
-		std::vector<float> m_write;
-		std::vector<float> m_read;
-		size_t m_flush_size;
-		uint64_t m_received_samples;
+		std::unique_ptr<Ring> m_ring;
+		std::vector<float> m_chunk;
+		std::vector<float> m_track_chunk;
+		std::atomic<uint64_t> m_received_samples;
+		std::atomic<uint64_t> m_dropped_samples;
+		uint64_t m_reported_dropped_samples;
 
-		Wav m_output;
-		std::string m_filename;
-		bool m_accepting;
+		std::vector<std::unique_ptr<AudioWriter>> m_outputs;
+		std::vector<std::string> m_filenames;
+		AudioFormat m_format;
+		RecordingLayout m_layout;
+		std::atomic<int> m_tracks;
+		std::atomic<bool> m_accepting;
 
 		void writeToFile();
 	};
@@ -4,39 +4,117 @@
 
 namespace sns
 {
+	//
+	// Neumaier compensated sum, values come and go for ever without the total drifting
+	//
+	class CompensatedSum {
+	public:
+		CompensatedSum() { reset(); }
+
+		void reset() {
+			m_sum = 0.0;
+			m_compensation = 0.0;
+		}
+
+		void add(double value) {
+			const double sum = m_sum + value;
+
+			if (absolute(m_sum) >= absolute(value))
+				m_compensation += (m_sum - sum) + value;
+			else
+				m_compensation += (value - sum) + m_sum;
+
+			m_sum = sum;
+		}
+
+		double value() const { return m_sum + m_compensation; }
+	private:
+		double m_sum;
+		double m_compensation;
+	};
+
+	//
+	// The last window values, storage is allocated once at construction
+	//
+	class RunningWindow {
+	public:
+		explicit RunningWindow(int window)
+			:m_values(size_t(clampAbove(window, 1))),
+			m_sorted(m_values.size())
+		{
+			clear();
+		}
+
+		void clear() {
+			m_count = 0;
+			m_next = 0;
+		}
+
+		// stores value, returns true and the value it replaced when the window was full
+		bool add(float value, float& dropped) {
+			const bool full = (m_count == m_values.size());
+			dropped = full ? m_values[m_next] : 0.0f;
+
+			m_values[m_next] = value;
+			m_next = (m_next + 1 == m_values.size()) ? 0 : m_next + 1;
+			if (!full)
+				++m_count;
+
+			return full;
+		}
+
+		size_t size() const { return m_count; }
+		size_t window() const { return m_values.size(); }
+
+		// value below which a fraction (0..1) of the window falls, O(window)
+		float percentile(float fraction) const {
+			if (m_count == 0)
+				return 0.0f;
+
+			std::copy(m_values.begin(), m_values.begin() + m_count, m_sorted.begin());
+
+			const size_t rank = size_t(clampTo(fraction, 0.0f, 1.0f) * float(m_count - 1) + 0.5f);
+			std::nth_element(m_sorted.begin(), m_sorted.begin() + rank, m_sorted.begin() + m_count);
+			return m_sorted[rank];
+		}
+	private:
+		std::vector<float> m_values;
+		mutable std::vector<float> m_sorted; // scratch for percentile
+		size_t m_count;
+		size_t m_next;
+	};
+
+
 	class RunningAverage {
 	public:
 		explicit RunningAverage(int window, float initial_value = 0.0)
-			:m_window(window)
+			:m_samples(window)
 		{
 			reset(initial_value);
 		}
 
 		void reset(float initial_value) {
 			m_average = 0.0f;
-			m_sum = 0.0f;
+			m_sum.reset();
 			m_samples.clear();
 			add(initial_value);
 		}
 
 		float add(float value) {
-			m_samples.push_back(value);
-			m_sum += value;
-
-			if (m_samples.size() > m_window) {
-				m_sum -= m_samples.front();
-				m_samples.pop_front();
-			}
+			float dropped;
+			if (m_samples.add(value, dropped))
+				m_sum.add(-double(dropped));
+			m_sum.add(double(value));
 
-			m_average = m_sum / float(m_samples.size());
+			m_average = float(m_sum.value() / double(m_samples.size()));
 			return m_average;
 		}
 
 		float average() const { return m_average; }
+		float percentile(float fraction) const { return m_samples.percentile(fraction); }
 	private:
-		int m_window;
-		std::list<float> m_samples;
-		float m_sum;
+		RunningWindow m_samples;
+		CompensatedSum m_sum;
 		float m_average;
 	};
 
@@ -44,38 +122,36 @@ namespace sns
 	class RunningRms {
 	public:
 		explicit RunningRms(int window, float initial_value = 0.0)
-			:m_window(window)
+			:m_samples(window)
 		{
 			reset(initial_value);
 		}
 
 		void reset(float initial_value) {
 			m_rms = 0.0f;
-			m_sum_of_squares = 0.0f;
+			m_sum_of_squares.reset();
 
 			m_samples.clear();
 			add(initial_value);
 		}
 
 		float add(float value) {
-			m_samples.push_back(value);
-			m_sum_of_squares += value * value;
+			float dropped;
+			if (m_samples.add(value, dropped))
+				m_sum_of_squares.add(-double(dropped) * double(dropped));
+			m_sum_of_squares.add(double(value) * double(value));
 
-			if (m_samples.size() > m_window) {
-				float front = m_samples.front();
-				m_samples.pop_front();
-				m_sum_of_squares -= front * front;
-			}
-
-			m_rms = std::sqrt(m_sum_of_squares / float(m_samples.size()));
+			m_rms = float(std::sqrt(clampAbove(m_sum_of_squares.value(), 0.0) / double(m_samples.size())));
 			return m_rms;
 		}
 
 		float rms() const { return m_rms; }
+
+		// percentile of the window values (not of the rms)
+		float percentile(float fraction) const { return m_samples.percentile(fraction); }
 	private:
-		int m_window;
-		std::list<float> m_samples;
-		float m_sum_of_squares;
+		RunningWindow m_samples;
+		CompensatedSum m_sum_of_squares;
 		float m_rms;
 	};
 
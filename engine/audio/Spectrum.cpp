@@ -0,0 +1,227 @@
+#include "Spectrum.hpp"
+
+#include "../core/Log.hpp"
+#include "../instrument/tb303/rosic_FourierTransformerRadix2.h"
+
+namespace sns {
+
+	std::string toString(FftWindow kind) {
+		switch (kind) {
+		case FftWindow::Rectangular: return "Rectangular";
+		case FftWindow::Hann: return "Hann";
+		case FftWindow::BlackmanHarris: return "Blackman-Harris";
+		default: break;
+		}
+		return "[FftWindow NOT_SET]";
+	}
+
+	struct Spectrum::PrivateImplementation {
+		Configuration cfg;
+		int hop = 0;
+		uint64_t last_position = 0;
+
+		rosic::FourierTransformerRadix2 fft;
+		std::vector<float> input;
+		std::vector<double> window;
+		std::vector<double> signal;
+		std::vector<double> magnitudes;
+		std::vector<double> power; // smoothed power per fft bin
+		double amplitude_scale = 1.0; // full scale sine reads 0 dB
+
+		// precomputed log binning, fft bins [first, last) or interpolated at position when narrower than a fft bin
+		struct Bin {
+			int first;
+			int last;
+			double position;
+		};
+		std::vector<Bin> bins;
+		std::vector<float> levels;
+		std::vector<float> frequencies;
+	};
+
+	Spectrum::Spectrum(Analyser& analyser)
+		:m_analyser(analyser),
+		m_pending_changed(true),
+		m_published_counter(0),
+		m_taken_counter(0),
+		m(std::make_unique<PrivateImplementation>())
+	{
+	}
+
+	Spectrum::~Spectrum() {
+		stopWorking();
+	}
+
+	void Spectrum::start(std::string const& key) {
+		remove(m_keys, key);
+		m_keys.push_back(key);
+
+		m_analyser.start(key);
+		if (!isWorking()) {
+			Log::d(TAG, "start");
+			startWorking();
+		}
+	}
+
+	void Spectrum::stop(std::string const& key) {
+		remove(m_keys, key);
+		m_analyser.stop(key);
+
+		if (m_keys.empty() && isWorking()) {
+			Log::d(TAG, "stop");
+			stopWorking();
+		}
+	}
+
+	bool Spectrum::isRunning() {
+		return isWorking();
+	}
+
+	void Spectrum::configure(Configuration const& configuration) {
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_pending = configuration;
+			m_pending_changed = true;
+		}
+		signalWorkArrived();
+	}
+
+	bool Spectrum::levels(std::vector<float>& levels, std::vector<float>& frequencies) {
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		if (m_taken_counter == m_published_counter)
+			return false;
+
+		levels = m_published_levels;
+		frequencies = m_published_frequencies;
+		m_taken_counter = m_published_counter;
+		return true;
+	}
+
+	void Spectrum::workStep() {
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			if (m_pending_changed) {
+				prepare(m_pending);
+				m_pending_changed = false;
+			}
+		}
+
+		const uint64_t written = m_analyser.written();
+		if (written < uint64_t(m->cfg.fft_size) || (written - m->last_position) < uint64_t(m->hop))
+			return;
+
+		m->last_position = written;
+		analyse();
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_published_levels = m->levels;
+		m_published_frequencies = m->frequencies;
+		m_published_counter++;
+	}
+
+	void Spectrum::prepare(Configuration const& configuration) {
+		Configuration cfg = configuration;
+
+		// power of two fft size
+		int fft_size = MinFftSize;
+		while (fft_size < cfg.fft_size && fft_size < MaxFftSize)
+			fft_size *= 2;
+		cfg.fft_size = fft_size;
+		cfg.overlap = clampTo(cfg.overlap, 0.0f, 0.95f);
+		cfg.smoothing = clampTo(cfg.smoothing, 0.0f, 0.99f);
+		cfg.bins = clampTo(cfg.bins, 2, 8192);
+
+		m->cfg = cfg;
+		m->hop = clampAbove(int(float(fft_size) * (1.0f - cfg.overlap)), 1);
+		m->last_position = 0;
+
+		// wake up about once per hop, but never slower than a ui frame
+		setSleepMs(clampTo(int(audioMilliseconds(uint64_t(m->hop))), 2, 16));
+
+		m->fft.setBlockSize(fft_size);
+		m->fft.setRealSignalMode(true);
+		m->input.assign(fft_size, 0.0f);
+		m->signal.assign(fft_size, 0.0);
+		m->magnitudes.assign(fft_size / 2, 0.0);
+		m->power.assign(fft_size / 2, 0.0);
+
+		m->window.resize(fft_size);
+		double window_sum = 0.0;
+		for (int i = 0; i != fft_size; ++i) {
+			const double x = 2.0 * double(PI) * double(i) / double(fft_size);
+			double w = 1.0;
+			if (cfg.window == FftWindow::Hann)
+				w = 0.5 - 0.5 * cos(x);
+			else if (cfg.window == FftWindow::BlackmanHarris)
+				w = 0.35875 - 0.48829 * cos(x) + 0.14128 * cos(2.0 * x) - 0.01168 * cos(3.0 * x);
+
+			m->window[i] = w;
+			window_sum += w;
+		}
+		m->amplitude_scale = 2.0 / window_sum;
+
+		// log spaced bins between MinFrequency and nyquist
+		const double nyquist = double(SampleRate) / 2.0;
+		const double ratio = nyquist / double(MinFrequency);
+		const double bin_hz = double(SampleRate) / double(fft_size);
+		const int last_fft_bin = fft_size / 2;
+
+		m->bins.resize(cfg.bins);
+		m->levels.assign(cfg.bins, FloorDb);
+		m->frequencies.resize(cfg.bins);
+
+		for (int i = 0; i != cfg.bins; ++i) {
+			const double steps = double(cfg.bins - 1);
+			const double center = double(MinFrequency) * pow(ratio, double(i) / steps);
+			const double low = double(MinFrequency) * pow(ratio, (double(i) - 0.5) / steps);
+			const double high = double(MinFrequency) * pow(ratio, (double(i) + 0.5) / steps);
+
+			auto& bin = m->bins[i];
+			bin.first = clampTo(int(ceil(low / bin_hz)), 1, last_fft_bin);
+			bin.last = clampTo(int(floor(high / bin_hz)) + 1, 1, last_fft_bin);
+			bin.position = clampTo(center / bin_hz, 1.0, double(last_fft_bin - 1));
+
+			m->frequencies[i] = float(center);
+		}
+
+		Log::d(TAG, sfmt("fft_size=%d window=%s hop=%d smoothing=%.2f bins=%d",
+			fft_size, toString(cfg.window), m->hop, cfg.smoothing, cfg.bins));
+	}
+
+	void Spectrum::analyse() {
+		const int fft_size = m->cfg.fft_size;
+
+		if (m_analyser.latest(m->input.data(), fft_size) != fft_size)
+			return;
+
+		for (int i = 0; i != fft_size; ++i)
+			m->signal[i] = double(m->input[i]) * m->window[i];
+
+		m->fft.getRealSignalMagnitudes(m->signal.data(), m->magnitudes.data());
+
+		const double smoothing = double(m->cfg.smoothing);
+		const int count = fft_size / 2;
+		for (int k = 0; k != count; ++k) {
+			const double amplitude = std::abs(m->magnitudes[k]) * m->amplitude_scale;
+			m->power[k] = smoothing * m->power[k] + (1.0 - smoothing) * amplitude * amplitude;
+		}
+
+		for (size_t i = 0; i != m->bins.size(); ++i) {
+			auto const& bin = m->bins[i];
+			double power = 0.0;
+
+			if (bin.last > bin.first) {
+				for (int k = bin.first; k != bin.last; ++k)
+					power = maximum(power, m->power[k]);
+			}
+			else {
+				const int k = int(bin.position);
+				const double alpha = bin.position - double(k);
+				power = m->power[k] * (1.0 - alpha) + m->power[k + 1] * alpha;
+			}
+
+			m->levels[i] = maximum(float(10.0 * log10(power + 1e-24)), FloorDb);
+		}
+	}
+}
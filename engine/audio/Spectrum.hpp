@@ -0,0 +1,74 @@
+#pragma once
+
+#include "../core/Lang.hpp"
+#include "../core/Worker.hpp"
+#include "Audio.hpp"
+#include "Analyser.hpp"
+
+namespace sns {
+
+	enum class FftWindow {
+		Rectangular,
+		Hann,
+		BlackmanHarris
+	};
+
+	//
+	// FFT of the analyser history computed on its own thread (never on the audio thread)
+	// and folded into log spaced bins ready to be drawn
+	//
+	class Spectrum : public Worker {
+	public:
+		static constexpr int MinFftSize = 256;
+		static constexpr int MaxFftSize = 16384;
+		static constexpr float MinFrequency = 20.0f;
+		static constexpr float FloorDb = -120.0f;
+
+		struct Configuration {
+			int fft_size = 4096;
+			FftWindow window = FftWindow::Hann;
+			float overlap = 0.5f;		// 0 ... 0.95 of the fft size
+			float smoothing = 0.7f;		// 0 (none) ... 0.99, per bin exponential smoothing
+			int bins = 512;				// log spaced output bins from MinFrequency to nyquist
+		};
+
+		explicit Spectrum(Analyser& analyser);
+		~Spectrum() override;
+
+		void start(std::string const& key);
+		void stop(std::string const& key);
+		bool isRunning();
+
+		void configure(Configuration const& configuration);
+
+		// copies the latest levels (dB) and the center frequency of each bin, returns false when nothing changed
+		bool levels(std::vector<float>& levels, std::vector<float>& frequencies);
+
+	protected:
+		void workStep() override;
+
+	private:
+		const std::string TAG = "Spectrum";
+		Analyser& m_analyser;
+		std::vector<std::string> m_keys;
+
+		std::mutex m_mutex;
+		Configuration m_pending;
+		bool m_pending_changed;
+
+		// published results, guarded by m_mutex
+		std::vector<float> m_published_levels;
+		std::vector<float> m_published_frequencies;
+		uint64_t m_published_counter;
+		uint64_t m_taken_counter;
+
+		// worker thread state
+		struct PrivateImplementation;
+		std::unique_ptr<PrivateImplementation> m;
+
+		void prepare(Configuration const& configuration);
+		void analyse();
+	};
+
+	std::string toString(FftWindow kind);
+}
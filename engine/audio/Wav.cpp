@@ -1,38 +1,78 @@
 #include "Wav.hpp"
+#include "WavReader.hpp"
 #include <stdio.h>
+#include <cstring>
 
-// https://github.com/mhroth/tinywav/blob/master/tinywav.c
-
-struct WavHeader {
-	uint8_t ChunkID[4] = { 'R', 'I', 'F', 'F' };		// RIFF Header Magic header
-	uint32_t ChunkSize = 0;
-	uint8_t Format[4] = { 'W', 'A', 'V', 'E' };			// WAVE Header
-	uint8_t Subchunk1ID[4] = { 'f', 'm', 't', ' ' };	// FMT header
-	uint32_t Subchunk1Size = 0;
-	uint16_t AudioFormat = 0;							//3 - float | 1 - pcm
-	uint16_t NumChannels = 0;
-	uint32_t SampleRate = 0;
-	uint32_t ByteRate = 0;
-	uint16_t BlockAlign = 0;
-	uint16_t BitsPerSample = 0;
-	uint8_t Subchunk2ID[4] = { 'd', 'a', 't', 'a' };	// "data"  string
-	uint32_t Subchunk2Size = 0;
-};
 namespace sns {
 
+	constexpr size_t WavFileBuffer = 1 << 20;
+	constexpr size_t WavJunkSize = 28; // room for a ds64 chunk if the file becomes RF64
+	constexpr uint64_t WavRiffLimit = 0xFFFFFFFFull;
+
+	static void putTag(uint8_t* destination, char const* tag) { memcpy(destination, tag, 4); }
+	static void put16(uint8_t* destination, uint16_t value) { destination[0] = uint8_t(value); destination[1] = uint8_t(value >> 8); }
+	static void put32(uint8_t* destination, uint32_t value) { put16(destination, uint16_t(value)); put16(destination + 2, uint16_t(value >> 16)); }
+	static void put64(uint8_t* destination, uint64_t value) { put32(destination, uint32_t(value)); put32(destination + 4, uint32_t(value >> 32)); }
+
 	struct Wav::PrivateImplementation {
 		FILE* file = nullptr;
-		WavHeader header;
-		uint32_t frames_on_file = 0;
+		int bits = 32;
+		int channels = 1;
+		uint64_t frames_on_file = 0;
+
+		std::unique_ptr<Dither> dither;
+		std::vector<char> file_buffer;
+		std::vector<int32_t> quantized;
+		std::vector<uint8_t> bytes;
+
+		//
+		// RIFF/RF64, JUNK/ds64, fmt, data
+		//
+		static constexpr size_t HeaderSize = 12 + 8 + WavJunkSize + 8 + 16 + 8;
+
+		void writeHeader(bool final) {
+			uint8_t header[HeaderSize] = {};
+			const uint32_t sample_bytes = uint32_t(bits / 8);
+			const uint64_t data_size = frames_on_file * uint64_t(channels) * sample_bytes;
+			const uint64_t riff_size = HeaderSize - 8 + data_size;
+			const bool rf64 = final && riff_size > WavRiffLimit;
+
+			uint8_t* at = header;
+			putTag(at, rf64 ? "RF64" : "RIFF"); put32(at + 4, rf64 ? 0xFFFFFFFFu : uint32_t(riff_size)); putTag(at + 8, "WAVE"); at += 12;
+
+			putTag(at, rf64 ? "ds64" : "JUNK"); put32(at + 4, uint32_t(WavJunkSize)); at += 8;
+			if (rf64) {
+				put64(at, riff_size);
+				put64(at + 8, data_size);
+				put64(at + 16, frames_on_file);
+				put32(at + 24, 0); // no table
+			}
+			at += WavJunkSize;
+
+			putTag(at, "fmt "); put32(at + 4, 16); at += 8;
+			put16(at, (bits == 32) ? 3 : 1); // 3 IEEE float, 1 PCM
+			put16(at + 2, uint16_t(channels));
+			put32(at + 4, uint32_t(sns::SampleRate));
+			put32(at + 8, uint32_t(sns::SampleRate) * uint32_t(channels) * sample_bytes);
+			put16(at + 12, uint16_t(uint32_t(channels) * sample_bytes));
+			put16(at + 14, uint16_t(bits));
+			at += 16;
+
+			putTag(at, "data"); put32(at + 4, rf64 ? 0xFFFFFFFFu : uint32_t(data_size));
+
+			fwrite(header, sizeof(header), 1, file);
+		}
 	};
 
-	Wav::Wav() 
+	Wav::Wav(int bits) 
 		: m(std::make_shared<PrivateImplementation>()),
 		m_is_ok(false)
 	{
+		assert(bits == 16 || bits == 24 || bits == 32);
+		m->bits = bits;
 	}
 
-	bool Wav::open(std::string const& filename)
+	bool Wav::open(std::string const& filename, int channels)
 	{
 		close();
 
@@ -42,29 +82,16 @@ namespace sns {
 		m->file = fopen(filename.c_str(), "wb");
 		if (m->file)
 		{
+			// the writer thread hands over large blocks, let stdio group them further
+			m->file_buffer.resize(WavFileBuffer);
+			setvbuf(m->file, m->file_buffer.data(), _IOFBF, m->file_buffer.size());
 
 			m->frames_on_file = 0;
-			const int channels = 1;
-
-			const int sample_bytes = 4; // float
-			WavHeader *header = &(m->header);
+			m->channels = clampAbove(channels, 1);
+			m->dither = (m->bits == 32) ? nullptr : std::make_unique<Dither>(m->bits);
 
-			// prepare WAV header
-			header->ChunkSize = 0;							   // fill this in on file-close
-			header->Subchunk1Size = 16;						   // PCM
-			header->AudioFormat = (sample_bytes == 4) ? 3 : 1; // 1 PCM, 3 IEEE float
-			header->NumChannels = channels;
-			header->SampleRate = sns::SampleRate;
-			header->ByteRate = sns::SampleRate * channels * sample_bytes;
-			header->BlockAlign = channels * sample_bytes;
-			header->BitsPerSample = 8 * sample_bytes;
-			header->Subchunk2Size = 0; // fill this in on file-close
-
-			int header_size = sizeof(WavHeader);
-			assert(header_size == 44);
-
-			// write WAV header
-			fwrite(header, header_size, 1, m->file);
+			// sizes are filled in on file-close
+			m->writeHeader(false);
 
 			m_is_ok = true;
 		}
@@ -72,14 +99,34 @@ namespace sns {
 		return m_is_ok;
 	}
 
-	int Wav::write(float* data, int frames) {
+	int Wav::write(float const* data, int frames) {
+		if (!m->file || frames <= 0)
+			return 0;
 
-		int samples = int(m->header.NumChannels) * frames;
+		const int samples = m->channels * frames;
+
+		size_t written;
+		if (m->bits == 32) {
+			written = fwrite(data, sizeof(float), samples, m->file);
+		}
+		else {
+			const int sample_bytes = m->bits / 8;
+			m->quantized.resize(samples);
+			m->bytes.resize(size_t(samples) * sample_bytes);
+			m->dither->quantize(data, m->quantized.data(), samples);
+
+			uint8_t* at = m->bytes.data();
+			for (int32_t value : m->quantized) {
+				for (int byte = 0; byte != sample_bytes; ++byte)
+					*at++ = uint8_t(value >> (8 * byte));
+			}
 
-		m->frames_on_file += frames;
-		size_t written = fwrite(data, sizeof(float), samples, m->file);
+			written = fwrite(m->bytes.data(), sample_bytes, samples, m->file);
+		}
 
-		return (int)written / (int)m->header.NumChannels;
+		const int frames_written = (int)written / m->channels;
+		m->frames_on_file += frames_written;
+		return frames_written;
 	}
 
 	Wav::~Wav() {
@@ -90,20 +137,14 @@ namespace sns {
 
 		if (m->file){
 
-			uint32_t sample_size = m->header.BitsPerSample / 8;
-			uint32_t channels = m->header.NumChannels;
-			uint32_t data_len = m->frames_on_file * channels * sample_size;
-
-			m->header.ChunkSize = 36 + data_len;
-			m->header.Subchunk2Size = data_len;
-
 			fseek(m->file, 0, SEEK_SET);
-			fwrite(&m->header, sizeof(WavHeader), 1, m->file);
+			m->writeHeader(true);
 
 			fclose(m->file);
 			m->file = nullptr;
 		}
 
+		m->file_buffer = std::vector<char>();
 		m_filename = "";
 		m_is_ok = false;
 	}
@@ -117,62 +158,28 @@ namespace sns {
 	std::vector<float> Wav::load(std::string const& filename) {
 		std::vector<float> data;
 
-			//
-			// Reading
-			//
-			FILE* file = fopen(filename.c_str(), "rb");
-			if (file == nullptr) 
-				return data;
-
-
-			WavHeader header;
-
-			size_t ret = fread(&header, sizeof(WavHeader), 1, file);
-
-			bool ok = (ret > 0);
-
-			ok &= header.ChunkID[0] == 'R';
-			ok &= header.ChunkID[1] == 'I';
-			ok &= header.ChunkID[2] == 'F';
-			ok &= header.ChunkID[3] == 'F';
-
-			ok &= header.Format[0] == 'W';
-			ok &= header.Format[1] == 'A';
-			ok &= header.Format[2] == 'V';
-			ok &= header.Format[3] == 'E';
-
-			ok &= header.Subchunk1ID[0] == 'f';
-			ok &= header.Subchunk1ID[1] == 'm';
-			ok &= header.Subchunk1ID[2] == 't';
-			ok &= header.Subchunk1ID[3] == ' ';
-
-			ok &= header.Subchunk2ID[0] == 'd';
-			ok &= header.Subchunk2ID[1] == 'a';
-			ok &= header.Subchunk2ID[2] == 't';
-			ok &= header.Subchunk2ID[3] == 'a';
-
-			uint32_t samples = 0;
-
-			if (ok){
-				uint32_t sample_bytes = header.BitsPerSample / 8;
-				samples = header.Subchunk2Size / sample_bytes;
+		WavReader reader;
+		if (!reader.open(filename) || reader.sampleRate() != sns::SampleRate)
+			return data;
 
-				ok = (samples > 0);
+		// channels are averaged down to mono
+		const int channels = reader.channels();
+		const int chunk_frames = 4096;
+		std::vector<float> chunk(size_t(chunk_frames) * channels);
 
+		data.reserve(size_t(reader.frames()));
 
-				// 32 bit float, mono
-				ok &= (header.NumChannels == 1);
-				ok &= (header.SampleRate == sns::SampleRate);
-				ok &= (header.BitsPerSample == 32);
-				ok &= (header.AudioFormat == 3); // float
-			}
-
-			if (ok) {
-				data.resize(samples);
-				fread(data.data(), sizeof(float), samples, file);
+		int frames;
+		while ((frames = reader.pull(chunk.data(), chunk_frames)) != 0) {
+			for (int frame = 0; frame != frames; ++frame) {
+				float sum = 0.0f;
+				for (int channel = 0; channel != channels; ++channel)
+					sum += chunk[frame * channels + channel];
+				data.push_back(sum / float(channels));
 			}
+		}
 
-			return data;
+		return data;
 	}
 
 }
\ No newline at end of file
@@ -1,22 +1,23 @@
 #pragma once
 
-#include "../audio/Audio.hpp"
+#include "AudioWriter.hpp"
 
 namespace sns {
 
 	//
-	// wav writer
+	// wav writer, 32 bit float or dithered 16/24 bit pcm, becomes RF64 when it outgrows 4GB
 	//
-	class Wav {
+	class Wav : public AudioWriter {
 	public:
-		Wav();
-		~Wav();
+		explicit Wav(int bits = 32);
+		~Wav() override;
 
-		bool open(std::string const& filename);
-		void close();
-		bool isOk();
-		int write(float* data, int frames);
+		bool open(std::string const& filename, int channels = 1) override;
+		void close() override;
+		bool isOk() override;
+		int write(float const* data, int frames) override; // frames of interleaved channels
 
+		// whole file as mono at the engine sample rate, use WavReader to stream large files
 		static std::vector<float> load(std::string const& filename);
 	private:
 		struct PrivateImplementation;
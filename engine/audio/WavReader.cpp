@@ -0,0 +1,168 @@
+#include "WavReader.hpp"
+#include <cstring>
+
+namespace sns {
+
+	static uint16_t get16(uint8_t const* source) { return uint16_t(source[0] | (source[1] << 8)); }
+	static uint32_t get32(uint8_t const* source) { return uint32_t(get16(source)) | (uint32_t(get16(source + 2)) << 16); }
+	static uint64_t get64(uint8_t const* source) { return uint64_t(get32(source)) | (uint64_t(get32(source + 4)) << 32); }
+
+	constexpr uint16_t WavFormatPcm = 1;
+	constexpr uint16_t WavFormatFloat = 3;
+	constexpr uint16_t WavFormatExtensible = 0xFFFE;
+
+	WavReader::WavReader()
+		:m_data(nullptr),
+		m_frames(0),
+		m_position(0),
+		m_sample_rate(0),
+		m_channels(0),
+		m_bits(0),
+		m_float(false)
+	{
+	}
+
+	WavReader::~WavReader() {
+		close();
+	}
+
+	bool WavReader::open(std::string const& filename) {
+		close();
+
+		if (!m_file.open(filename))
+			return false;
+
+		if (!parse()) {
+			close();
+			return false;
+		}
+
+		return true;
+	}
+
+	void WavReader::close() {
+		m_file.close();
+		m_data = nullptr;
+		m_frames = 0;
+		m_position = 0;
+		m_sample_rate = 0;
+		m_channels = 0;
+		m_bits = 0;
+		m_float = false;
+	}
+
+	bool WavReader::isOpen() const {
+		return m_data != nullptr;
+	}
+
+	int WavReader::channels() const { return m_channels; }
+	uint32_t WavReader::sampleRate() const { return m_sample_rate; }
+	int WavReader::bits() const { return m_bits; }
+	bool WavReader::isFloat() const { return m_float; }
+	uint64_t WavReader::frames() const { return m_frames; }
+
+	bool WavReader::parse() {
+		uint8_t const* file = m_file.data();
+		const uint64_t size = m_file.size();
+
+		if (size < 12 || memcmp(file + 8, "WAVE", 4) != 0)
+			return false;
+
+		const bool rf64 = memcmp(file, "RF64", 4) == 0;
+		if (!rf64 && memcmp(file, "RIFF", 4) != 0)
+			return false;
+
+		uint64_t rf64_data_size = 0;
+		uint16_t format = 0;
+		uint64_t offset = 12;
+
+		while (offset + 8 <= size) {
+			uint8_t const* chunk = file + offset;
+			uint64_t chunk_size = get32(chunk + 4);
+			offset += 8;
+
+			// fields are only read from chunks held whole by the file, the data chunk may be cut short
+			const bool complete = chunk_size <= size - offset;
+
+			if (memcmp(chunk, "ds64", 4) == 0 && complete && chunk_size >= 16) {
+				rf64_data_size = get64(chunk + 16);
+			}
+			else if (memcmp(chunk, "fmt ", 4) == 0 && complete && chunk_size >= 16) {
+				format = get16(chunk + 8);
+				m_channels = get16(chunk + 10);
+				m_sample_rate = get32(chunk + 12);
+				m_bits = get16(chunk + 22);
+
+				// the sub format guid starts with the format tag
+				if (format == WavFormatExtensible && chunk_size >= 40)
+					format = get16(chunk + 32);
+			}
+			else if (memcmp(chunk, "data", 4) == 0) {
+				if (rf64 && chunk_size == 0xFFFFFFFFull)
+					chunk_size = rf64_data_size;
+
+				// a recording that was never closed has no size yet, or a truncated one
+				if (chunk_size == 0 || chunk_size > size - offset)
+					chunk_size = size - offset;
+
+				m_float = (format == WavFormatFloat);
+
+				const bool supported = (format == WavFormatPcm && (m_bits == 16 || m_bits == 24 || m_bits == 32)) ||
+					(format == WavFormatFloat && m_bits == 32);
+
+				if (!supported || m_channels <= 0)
+					return false;
+
+				m_data = file + offset;
+				m_frames = chunk_size / (uint64_t(m_channels) * uint64_t(m_bits / 8));
+				return true;
+			}
+
+			offset += chunk_size + (chunk_size & 1);
+		}
+
+		return false;
+	}
+
+	int WavReader::read(uint64_t frame, float* output, int count) const {
+		if (!m_data || frame >= m_frames || count <= 0)
+			return 0;
+
+		const int frames = int(minimum(uint64_t(count), m_frames - frame));
+		const size_t samples = size_t(frames) * size_t(m_channels);
+		const size_t sample_bytes = size_t(m_bits / 8);
+		uint8_t const* source = m_data + frame * uint64_t(m_channels) * sample_bytes;
+
+		if (m_float) {
+			memcpy(output, source, samples * sizeof(float));
+		}
+		else if (m_bits == 16) {
+			for (size_t i = 0; i != samples; ++i, source += 2)
+				output[i] = float(int16_t(get16(source))) * (1.0f / 32768.0f);
+		}
+		else if (m_bits == 24) {
+			for (size_t i = 0; i != samples; ++i, source += 3)
+				output[i] = float(int32_t(uint32_t(source[0] << 8) | uint32_t(source[1] << 16) | uint32_t(source[2]) << 24) >> 8) * (1.0f / 8388608.0f);
+		}
+		else {
+			for (size_t i = 0; i != samples; ++i, source += 4)
+				output[i] = float(double(int32_t(get32(source))) * (1.0 / 2147483648.0));
+		}
+
+		return frames;
+	}
+
+	uint64_t WavReader::position() const {
+		return m_position;
+	}
+
+	void WavReader::seek(uint64_t frame) {
+		m_position = minimum(frame, m_frames);
+	}
+
+	int WavReader::pull(float* output, int count) {
+		const int frames = read(m_position, output, count);
+		m_position += uint64_t(frames);
+		return frames;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Audio.hpp"
+#include "../core/MappedFile.hpp"
+
+namespace sns {
+
+	//
+	// Reads wav files (16/24/32 bit pcm, 32 bit float, RIFF or RF64) through a memory mapping,
+	// frames are decoded on demand so a file of any size costs no memory up front
+	//
+	class WavReader {
+	public:
+		WavReader();
+		~WavReader();
+
+		WavReader(const WavReader& other) = delete;
+		WavReader& operator=(const WavReader& other) = delete;
+
+		bool open(std::string const& filename);
+		void close();
+		bool isOpen() const;
+
+		int channels() const;
+		uint32_t sampleRate() const;
+		int bits() const;
+		bool isFloat() const;
+		uint64_t frames() const;
+
+		// decodes up to count frames starting at frame as interleaved floats, returns the frames read
+		int read(uint64_t frame, float* output, int count) const;
+
+		// sequential reading
+		uint64_t position() const;
+		void seek(uint64_t frame);
+		int pull(float* output, int count);
+	private:
+		MappedFile m_file;
+		uint8_t const* m_data;
+		uint64_t m_frames;
+		uint64_t m_position;
+		uint32_t m_sample_rate;
+		int m_channels;
+		int m_bits;
+		bool m_float;
+
+		bool parse();
+	};
+
+}
\ No newline at end of file
@@ -0,0 +1,130 @@
+#include "MappedFile.hpp"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace sns {
+
+	MappedFile::MappedFile()
+		:m_data(nullptr),
+		m_size(0),
+#if defined(_WIN32)
+		m_file(INVALID_HANDLE_VALUE),
+		m_mapping(nullptr)
+#else
+		m_file(-1)
+#endif
+	{
+	}
+
+	MappedFile::~MappedFile() {
+		close();
+	}
+
+	bool MappedFile::isOpen() const {
+		return m_data != nullptr;
+	}
+
+	uint8_t const* MappedFile::data() const {
+		return m_data;
+	}
+
+	size_t MappedFile::size() const {
+		return m_size;
+	}
+
+#if defined(_WIN32)
+
+	bool MappedFile::open(std::string const& filename) {
+		close();
+
+		m_file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (m_file == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0) {
+			close();
+			return false;
+		}
+
+		m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (m_mapping == nullptr) {
+			close();
+			return false;
+		}
+
+		m_data = (uint8_t const*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+		if (m_data == nullptr) {
+			close();
+			return false;
+		}
+
+		m_size = size_t(size.QuadPart);
+		return true;
+	}
+
+	void MappedFile::close() {
+		if (m_data)
+			UnmapViewOfFile(m_data);
+
+		if (m_mapping)
+			CloseHandle(m_mapping);
+
+		if (m_file != INVALID_HANDLE_VALUE)
+			CloseHandle(m_file);
+
+		m_data = nullptr;
+		m_size = 0;
+		m_mapping = nullptr;
+		m_file = INVALID_HANDLE_VALUE;
+	}
+
+#else
+
+	bool MappedFile::open(std::string const& filename) {
+		close();
+
+		m_file = ::open(filename.c_str(), O_RDONLY);
+		if (m_file < 0)
+			return false;
+
+		struct stat info;
+		if (fstat(m_file, &info) != 0 || info.st_size == 0) {
+			close();
+			return false;
+		}
+
+		void* mapped = mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_PRIVATE, m_file, 0);
+		if (mapped == MAP_FAILED) {
+			close();
+			return false;
+		}
+
+		m_data = (uint8_t const*)mapped;
+		m_size = size_t(info.st_size);
+		return true;
+	}
+
+	void MappedFile::close() {
+		if (m_data)
+			munmap((void*)m_data, m_size);
+
+		if (m_file >= 0)
+			::close(m_file);
+
+		m_data = nullptr;
+		m_size = 0;
+		m_file = -1;
+	}
+
+#endif
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Lang.hpp"
+
+namespace sns {
+
+	//
+	// Read only memory mapping of a file, pages are only loaded by the os when touched
+	//
+	class MappedFile {
+	public:
+		MappedFile();
+		~MappedFile();
+
+		MappedFile(const MappedFile& other) = delete;
+		MappedFile(MappedFile&& other) = delete;
+		MappedFile& operator=(const MappedFile& other) = delete;
+		MappedFile& operator=(MappedFile&& other) = delete;
+
+		bool open(std::string const& filename);
+		void close();
+
+		bool isOpen() const;
+		uint8_t const* data() const;
+		size_t size() const;
+	private:
+		uint8_t const* m_data;
+		size_t m_size;
+
+#if defined(_WIN32)
+		void* m_file;
+		void* m_mapping;
+#else
+		int m_file;
+#endif
+	};
+}
@@ -0,0 +1,22 @@
+#include "Snapshot.hpp"
+
+namespace sns {
+
+	Reclaimer::Reclaimer()
+		:m_head(0),
+		m_tail(0)
+	{
+	}
+
+	void Reclaimer::collect() {
+		std::unique_lock<std::mutex> lock(m_collect_mutex);
+
+		const uint64_t head = m_head.load(std::memory_order_acquire);
+		uint64_t tail = m_tail.load(std::memory_order_relaxed);
+
+		for (; tail != head; ++tail)
+			m_slots[tail % Capacity].reset();
+
+		m_tail.store(tail, std::memory_order_release);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Lang.hpp"
+
+#include <atomic>
+#include <mutex>
+
+namespace sns {
+
+	//
+	// An immutable, reference counted value handed to the audio thread: passing it around
+	// only moves a pointer, the contents are never copied once published
+	//
+	template <typename T>
+	using Snapshot = std::shared_ptr<T const>;
+
+	//
+	// Snapshots the audio thread is done with, kept alive in a preallocated ring until collect()
+	// releases them on another thread, so the callback never runs a destructor or frees memory.
+	// Single producer (the audio thread), collect() may be called from any other thread.
+	//
+	class Reclaimer {
+	public:
+		static constexpr size_t Capacity = 256;
+
+		Reclaimer();
+
+		Reclaimer(Reclaimer const&) = delete;
+		Reclaimer& operator=(Reclaimer const&) = delete;
+
+		// audio thread, gives up the reference (only released right away when the ring is full)
+		template <typename T>
+		void retire(Snapshot<T>&& snapshot) {
+			if (!snapshot)
+				return;
+
+			const uint64_t head = m_head.load(std::memory_order_relaxed);
+			if (head - m_tail.load(std::memory_order_acquire) == Capacity) {
+				snapshot.reset();
+				return;
+			}
+
+			m_slots[head % Capacity] = std::move(snapshot);
+			m_head.store(head + 1, std::memory_order_release);
+		}
+
+		// releases everything retired so far
+		void collect();
+	private:
+		std::array<std::shared_ptr<void const>, Capacity> m_slots;
+		std::atomic<uint64_t> m_head;
+		std::atomic<uint64_t> m_tail;
+		std::mutex m_collect_mutex;
+	};
+}
\ No newline at end of file
@@ -1,10 +1,10 @@
 #include "DrumMachine.hpp"
+#include "drummachine/DrumFont.hpp"
 #include "../core/Log.hpp"
+#include "../core/Worker.hpp"
 
-#define TML_IMPLEMENTATION
-#include "tsf/tml.h"
+#include <atomic>
 
-#define TSF_IMPLEMENTATION
 #include "tsf/tsf.h"
 
 namespace drummachine {
@@ -13,14 +13,125 @@ namespace drummachine {
 
 namespace sns {
 
-	constexpr int SAMPLE_PACKET = 64;
+	constexpr int SAMPLE_PACKET = DrumVoices::Block;
+	constexpr float PITCH_BEND_RANGE = 2.0f; // semitones, same as the tsf channel default
+
+	static std::unique_ptr<DrumFont> embeddedFont() {
+		auto font = DrumFont::fromMemory(drummachine::sf2_data, sizeof(drummachine::sf2_data));
+		if (!font)
+			font = std::make_unique<DrumFont>();
+		return font;
+	}
+
+	//
+	// Loads user fonts (or the embedded one, for an empty filename) away from the audio thread.
+	// The audio thread picks up a loaded font with exchange() and hands back the one it replaced, which is deleted here.
+	// The one-shots of the last font loaded are rendered here as they get hit.
+	//
+	class DrumFontLoader : public Worker {
+	public:
+		DrumFontLoader()
+			:m_has_pending(false),
+			m_ready(nullptr),
+			m_retired(nullptr),
+			m_current(nullptr)
+		{
+			setSleepMs(20);
+		}
+
+		~DrumFontLoader() override {
+			stopWorking();
+		}
+
+		void load(std::string const& filename) {
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_pending = filename;
+				m_has_pending = true;
+			}
+
+			if (!isWorking())
+				startWorking();
+
+			signalWorkArrived();
+		}
+
+		// audio thread, lock and allocation free
+		DrumFont* exchange(DrumFont* current) {
+			if (m_retired.load() != nullptr || m_ready.load() == nullptr)
+				return current;
+
+			DrumFont* loaded = m_ready.exchange(nullptr);
+			if (loaded == nullptr)
+				return current;
+
+			m_retired.store(current);
+			return loaded;
+		}
+
+	protected:
+		void workStep() override {
+			// older than m_current, which is only replaced by a font loaded after it
+			delete m_retired.exchange(nullptr);
+
+			if (m_current)
+				m_current->voices.prepareRequested();
+
+			std::string filename;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				if (!m_has_pending)
+					return;
+
+				std::swap(filename, m_pending);
+				m_has_pending = false;
+			}
+
+			auto font = filename.empty() ? embeddedFont() : DrumFont::open(filename);
+			if (font) {
+				m_current = font.get();
+				delete m_ready.exchange(font.release());
+			}
+		}
+
+		void postWork() override {
+			m_current = nullptr;
+			delete m_retired.exchange(nullptr);
+			delete m_ready.exchange(nullptr);
+		}
+
+	private:
+		std::mutex m_mutex;
+		std::string m_pending;
+		bool m_has_pending;
+
+		std::atomic<DrumFont*> m_ready;
+		std::atomic<DrumFont*> m_retired;
+		DrumFont* m_current; // the last font loaded, ready or played
+	};
 
 	struct DrumMachine::PrivateImplementation {
 		bool do_log;
-		tsf* tsf;
+		std::unique_ptr<DrumFont> font;
+
+		float volume = 1.0f;
+		float pitch_bend = 0.0f;
 
 		std::array<float, SAMPLE_PACKET> produced;
-		size_t produced_index;
+		size_t produced_index = SAMPLE_PACKET;
+
+		DrumFontLoader loader;
+		std::string requested_font; // last kit asked for, empty for the embedded one
+
+		void apply(DrumFont& target) {
+			if (target.sound_font) {
+				tsf_set_volume(target.sound_font, volume);
+				tsf_channel_set_pitchwheel(target.sound_font, 0, int(pitch_bend * 8192.0f + 8192.0f));
+			}
+
+			target.voices.setVolume(volume);
+			target.voices.setPitchBend(pitch_bend * PITCH_BEND_RANGE);
+		}
 	};
 
 	std::vector<DrumMachine::DMKey> const& DrumMachine::tr808() {
@@ -99,10 +210,7 @@ namespace sns {
 	{
 		TAG = "DrumMachine";
 		m->do_log = false;
-		m->tsf = tsf_load_memory(drummachine::sf2_data, sizeof(drummachine::sf2_data));
-		if (m->tsf) {
-			tsf_set_output(m->tsf, TSFOutputMode::TSF_MONO, sns::SampleRate, 0);
-		}
+		m->font = embeddedFont();
 
 		panic();
 
@@ -116,28 +224,48 @@ namespace sns {
 		// ensure alias mapping is built
 		alias(0);
 
-		if (m->tsf == nullptr)
+		m->font->voices.reset();
+
+		if (m->font->sound_font == nullptr)
 			return;
 
-		tsf_reset(m->tsf);
+		tsf_reset(m->font->sound_font);
 	}
 
 	DrumMachine::~DrumMachine() {
-		if (m->tsf) {
-			tsf_close(m->tsf);
-			m->tsf = nullptr;
-		}
+		m->loader.stopWorking();
+	}
+
+	void DrumMachine::loadSoundFont(std::string const& filename) {
+		if (filename == m->requested_font)
+			return;
+
+		m->requested_font = filename;
+		m->loader.load(filename);
+	}
+
+	void DrumMachine::setSoundFont(std::string const& filename) {
+		auto font = filename.empty() ? embeddedFont() : DrumFont::open(filename);
+		if (!font)
+			return;
+
+		font->voices.prepareAll();
+		m->font = std::move(font);
+		m->requested_font = filename;
+		m->produced_index = SAMPLE_PACKET;
+		m->apply(*m->font);
 	}
 
 	void DrumMachine::onMidi(MidiMessage const& message) {
 		if (message.parameter == ParameterPitchBend) {
 
-			if (m->tsf) {
+			if (m->font->sound_font) {
 				int bend = int(message.parameter_value * 8192.0f + 8192.0f);
 
 				Log::d(TAG, sfmt("ParameterPitchBend %d [%.3f]", bend, message.parameter_value));
 
-				tsf_channel_set_pitchwheel(m->tsf, 0, bend);
+				m->pitch_bend = message.parameter_value;
+				m->apply(*m->font);
 			}
 
 		}
@@ -148,14 +276,21 @@ namespace sns {
 	}
 
 	void DrumMachine::setNote(int note, float velocity) {
-		if (m->tsf == nullptr)
+		DrumFont& font = *m->font;
+		if (font.sound_font == nullptr)
 			return;
 
-		if (velocity > 0.0f) {
-			tsf_note_on(m->tsf, 0, note, velocity);
+		if (!font.voices.empty()) {
+			if (velocity > 0.0f)
+				font.voices.noteOn(note, velocity);
+			else
+				font.voices.noteOff(note);
+		}
+		else if (velocity > 0.0f) {
+			tsf_note_on(font.sound_font, font.preset, note, velocity);
 		}
 		else {
-			tsf_note_off(m->tsf, 0, note);
+			tsf_note_off(font.sound_font, font.preset, note);
 		}
 	}
 
@@ -168,12 +303,13 @@ namespace sns {
 	}
 
 	void DrumMachine::setValues(ParametersValues const& values) {
-		if (m->tsf == nullptr)
+		if (m->font->sound_font == nullptr)
 			return;
 
 		for (auto const& [parameter, value] : values) {
 			if (parameter == ParameterVolume) {
-				tsf_set_volume(m->tsf, value);
+				m->volume = value;
+				m->apply(*m->font);
 			}
 		}
 
@@ -182,9 +318,24 @@ namespace sns {
 
 	float DrumMachine::next() {
 
-		if (m->tsf) {
+		if (m->produced_index == SAMPLE_PACKET) {
+			// swap in a font loaded in the background, on a packet boundary
+			DrumFont* current = m->font.get();
+			DrumFont* loaded = m->loader.exchange(current);
+			if (loaded != current) {
+				m->font.release();
+				m->font.reset(loaded);
+				m->apply(*loaded);
+			}
+		}
+
+		DrumFont& font = *m->font;
+		if (font.sound_font) {
 			if (m->produced_index == SAMPLE_PACKET) {
-				tsf_render_float(m->tsf, m->produced.data(), SAMPLE_PACKET, 0);
+				if (font.voices.empty())
+					tsf_render_float(font.sound_font, m->produced.data(), SAMPLE_PACKET, 0);
+				else
+					font.voices.render(m->produced.data(), SAMPLE_PACKET);
 				m->produced_index = 0;
 			}
 
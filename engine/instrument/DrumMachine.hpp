@@ -27,6 +27,13 @@ namespace sns {
 
 		float next() override;
 		void panic() override;
+
+		// maps and prepares a user SF2 in the background, it replaces the current kit once ready.
+		// An empty filename goes back to the embedded kit, the kit already asked for is not loaded again
+		void loadSoundFont(std::string const& filename);
+		// loads the kit right away on the calling thread, for a drum machine nothing is playing from (offline renders).
+		// The current kit is kept when it can't be loaded
+		void setSoundFont(std::string const& filename);
 	private:
 		struct PrivateImplementation;
 		std::unique_ptr<PrivateImplementation> m;
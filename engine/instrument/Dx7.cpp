@@ -13,6 +13,7 @@
 #include "dx7/controllers.h"
 #include "dx7/dx7note.h"
 #include "dx7/lfo.h"
+#include "dx7/PatchCache.hpp"
 
 #include "dx7/banks/Banks.hpp"
 
@@ -20,6 +21,7 @@ using namespace dx7;
 
 namespace sns {
 	constexpr int max_active_notes = 16;
+	constexpr int max_cached_banks = 3;
 
 	constexpr float VOLUME_RAMP_INCREMENT = 10.0f / float(SampleRate);
 
@@ -35,8 +37,11 @@ namespace sns {
 		Voice voices[max_active_notes];
 		int current_note;
 
-		uint8_t patch_data[4096];
-		char unpacked_patch[156];
+		// banks are prepared off the audio thread (prepareValues, prepareSysex), the audio thread takes
+		// the loaded bank and picks the active voice from it on program changes
+		PatchCache patch_cache{ max_cached_banks };
+		PreparedBankPtr bank;
+		PreparedPatchPtr patch;
 
 		// The original DX7 had one single LFO. Later units had an LFO per note.
 		Lfo lfo;
@@ -116,6 +121,7 @@ namespace sns {
 
 		m->volume = 1.0f;
 
+		Dx7::takePrepared(Dx7::prepareValues(Dx7::defaultParameters()));
 		Dx7::setValues(Dx7::defaultParameters());
 		m->do_log = true;
 	}
@@ -273,26 +279,12 @@ namespace sns {
 
 		if (group > -1 && bank > -1 && program > -1) {
 			if (group != m->group_index || bank != m->bank_index) {
-				Banks::BankInfo info = Banks::instance().bank(group, bank);
-				if (info.data && setSysex(info.data, info.size)) {
-
-					if (m->do_log)
-						Log::d(TAG, sfmt("Loaded %s/%s", info.group, info.bank));
-
-					m->group_index = group;
-					m->bank_index = bank;
-					m->program_index = -1;
-				}
-				else {
-
-					Log::e(TAG, sfmt("Invalid group=%d bank=%d", group, bank));
-					m->group_index = -1;
-					m->bank_index = -1;
-					m->program_index = -1;
-				}
+				// the bank comes prepared with the values and is never derived here,
+				// one sent by a controller stays until values bring another
+				if (m->group_index > -1)
+					Log::e(TAG, sfmt("Bank not prepared group=%d bank=%d", group, bank));
 			}
-
-			if (m->bank_index > -1 && (m->program_index != program)) {
+			else if (m->program_index != program) {
 				if (program < 32) {
 					programChange(program);
 					m->program_index = program;
@@ -306,6 +298,50 @@ namespace sns {
 		BaseInstrument::setValues(values);
 	}
 
+	// a 32 voice bank dump, the packed voices start after the 6 bytes of header
+	static bool isBankDump(const uint8_t* data, size_t size) {
+		return data && (size >= 4104) && (data[1] == 0x43 && data[2] == 0x00 && data[3] == 0x09 && data[4] == 0x20 && data[5] == 0x00);
+	}
+
+	Prepared Dx7::prepareValues(ParametersValues const& values) {
+		auto group = values.find(ParameterGroup);
+		auto bank = values.find(ParameterBank);
+		if (group == values.end() || bank == values.end() || group->second < 0.0f || bank->second < 0.0f)
+			return Prepared();
+
+		// a cached bank is handed over as it is, only a miss derives its voices
+		Banks::BankInfo info = Banks::instance().bank(int(group->second), int(bank->second));
+		if (!isBankDump(info.data, size_t(info.size))) {
+			Log::e(TAG, sfmt("Invalid group=%d bank=%d", int(group->second), int(bank->second)));
+			return Prepared();
+		}
+
+		return m->patch_cache.get(int(group->second), int(bank->second), info.data + 6);
+	}
+
+	Prepared Dx7::prepareSysex(uint8_t const* data, size_t size) {
+		if (!isBankDump(data, size))
+			return Prepared();
+
+		return m->patch_cache.prepare(data + 6);
+	}
+
+	void Dx7::takePrepared(Prepared const& prepared) {
+		auto bank = std::static_pointer_cast<PreparedBank const>(prepared);
+		if (!bank || bank == m->bank)
+			return;
+
+		retire(std::move(m->bank));
+		m->bank = std::move(bank);
+
+		m->group_index = m->bank->group;
+		m->bank_index = m->bank->bank;
+		m->program_index = -1;
+
+		if (m->do_log)
+			Log::d(TAG, sfmt("Loaded bank group=%d bank=%d", m->group_index, m->bank_index));
+	}
+
 	void Dx7::panic() {
 		BaseInstrument::panic();
 
@@ -313,6 +349,10 @@ namespace sns {
 			resetVoice(i);
 		}
 		internalTrackMidiNotesReset();
+
+		// drop what is left of the block already computed, the next one starts right away
+		m->produced.fill(0.0f);
+		m->produced_index = N;
 	}
 
 	void Dx7::resetVoice(int v) {
@@ -330,47 +370,18 @@ namespace sns {
 		if (m->do_log)
 			Log::d(TAG, sfmt("Changing program [%d]", p));
 
-		const uint8_t* patch = m->patch_data + 128 * p;
-		setPatch(patch, 128);
-		panic();
-	}
-
-	bool Dx7::setSysex(const uint8_t* data, uint32_t size) {
-		if ((size >= 4104) && (data[1] == 0x43 && data[2] == 0x00 && data[3] == 0x09 && data[4] == 0x20 && data[5] == 0x00)) {
-			memcpy(m->patch_data, data + 6, 4096);
-			return true;
-		}
-		return false;
-	}
-
-	void Dx7::setPatch(const uint8_t* patch, uint32_t size) {
-		char name[11];
-
-		if (size == 128) {
-			UnpackPatch((const char*)patch, m->unpacked_patch);
-			memcpy(name, m->unpacked_patch + 145, 10);
-			name[10] = 0;
-		}
-		else if (size == 145) {
-			memcpy(m->unpacked_patch, patch, size);
-			m->unpacked_patch[155] = 0x3f;  // operator on/off
-
-			strcpy(name, "custom");
-			name[6] = 0;
-		}
-		else {
+		if (!m->bank)
 			return;
-		}
 
-		//lfo_.reset((const char *)unpacked_patch_);
-		m->lfo.reset(m->unpacked_patch + 137);
+		// the voice replaced may be the last reference to a bank already retired
+		retire(std::move(m->patch));
+		m->patch = m->bank->patches[p];
+		m->lfo.reset(m->patch->unpacked + 137);
 
 		if (m->do_log)
-			Log::d(TAG, sfmt("Program Changed [%s]", name));
-	}
+			Log::d(TAG, sfmt("Program Changed [%s]", m->patch->name));
 
-	void Dx7::setParam(uint32_t id, char value) {
-		m->unpacked_patch[id] = value;
+		panic();
 	}
 
 	void Dx7::setNote(int note, float velocity) {
@@ -387,8 +398,16 @@ namespace sns {
 		if ((message.parameter != ParameterNone) && (message.parameter != ParameterPitchBend)) {
 			BaseInstrument::onMidi(message);
 		}
+		else if (message.sysex) {
+			// a bank sent by the controller replaces the loaded one, it was prepared on the midi thread
+			if (message.prepared && *message.prepared) {
+				takePrepared(*message.prepared);
+				programChange(0);
+			}
+		}
 		else {
-			onMidi(message.bytes.data(), int(message.bytes.size()));
+			if (message.size() > 0)
+				onMidi(message.data(), message.size());
 		}
 
 	}
@@ -413,7 +432,8 @@ namespace sns {
 				m->voices[note].keydown = true;
 				m->voices[note].sustained = m->sustain;
 				m->voices[note].live = true;
-				m->voices[note].dx7_note->init((uint8_t*)m->unpacked_patch, midinote, velocity);
+				if (m->patch)
+					m->voices[note].dx7_note->init(*m->patch, midinote, velocity);
 				break;
 			}
 			note = (note + 1) % max_active_notes;
@@ -514,12 +534,6 @@ namespace sns {
 			setController(kControllerPitch, data[1] | (data[2] << 7));
 
 		}
-		else if (cmd == 0xf0) {
-			//sysex
-
-			if (setSysex(data, data_size))
-				programChange(0);
-		}
 	}
 
 	float Dx7::next() {
@@ -13,6 +13,10 @@ namespace sns
 		static ParametersValues defaultParameters();
 		void setValues(ParametersValues const& values) override;
 
+		Prepared prepareValues(ParametersValues const& values) override;
+		Prepared prepareSysex(uint8_t const* data, size_t size) override;
+		void takePrepared(Prepared const& prepared) override;
+
 		void setNote(int note, float velocity) override;
 		void onMidi(MidiMessage const& message) override;
 
@@ -28,9 +32,6 @@ namespace sns
 		void programChange(int p);
 
 		void setController(int controller, int value);
-		bool setSysex(const uint8_t* data, uint32_t size);
-		void setPatch(const uint8_t* patch, uint32_t size);
-		void setParam(uint32_t id, char value);
 
 		// Choose a note for a new key-down, returns note number, or -1 if none available.
 		void resetVoice(int v);
@@ -1,5 +1,9 @@
 #include "Instrument.hpp"
 #include "../../engine/core/Text.hpp"
+#include "SynthMachine.hpp"
+#include "DrumMachine.hpp"
+#include "Dx7.hpp"
+#include "TB303.hpp"
 
 namespace sns {
 
@@ -54,6 +58,18 @@ namespace sns {
 		return InstrumentIdNone;
 	}
 
+	std::unique_ptr<BaseInstrument> createInstrument(InstrumentId id) {
+
+		switch (id) {
+		case InstrumentIdSynthMachine: return std::make_unique<SynthMachine>();
+		case InstrumentIdDrumMachine: return std::make_unique<DrumMachine>();
+		case InstrumentIdDx7: return std::make_unique<Dx7>();
+		case InstrumentIdTB303: return std::make_unique<TB303>();
+		}
+
+		return nullptr;
+	}
+
 	struct Mapper {
 		std::map<Parameter, std::string> parameterToName;
 		std::map<std::string, Parameter> nameToParameter;
@@ -150,6 +166,7 @@ namespace sns {
 				case ParameterTuning: return "Tuning";
 				case ParameterAccent: return "Accent";
 				case ParameterVolume: return "Volume";
+				case ParameterQuality: return "Quality";
 
 
 				default: break;
@@ -187,14 +204,21 @@ namespace sns {
 	BaseInstrument::BaseInstrument()
 		:TAG("BaseInstrument"),
 		m_midi_updated_values(false),
-		m_midi_updated_note_pressed(false)
+		m_midi_updated_note_pressed(false),
+		m_reclaimer(nullptr)
 	{
+		m_lane_notes.fill(0);
 	}
 
 	float BaseInstrument::next() {
 		return 0.0f;
 	}
 
+	void BaseInstrument::render(float* output, int count) {
+		for (int i = 0; i != count; ++i)
+			output[i] += next();
+	}
+
 	void BaseInstrument::onMidi(MidiMessage const& message) {
 		if (message.parameter != ParameterNone) {
 			auto values = m_values;
@@ -204,8 +228,10 @@ namespace sns {
 			return;
 		}
 
-		size_t data_size = message.bytes.size();
-		unsigned char const* data = message.bytes.data();
+		int data_size = message.size();
+		uint8_t const* data = message.data();
+		if (data_size < 1) return;
+
 		uint8_t cmd = data[0];
 		uint8_t cmd_type = cmd & 0xf0;
 
@@ -256,6 +282,26 @@ namespace sns {
 
 	}
 
+	void BaseInstrument::setLaneNote(int lane, int note, float velocity) {
+		if (lane < 0 || lane >= 32 || note < 0 || note >= int(m_lane_notes.size())) {
+			setNote(note, velocity);
+			return;
+		}
+
+		uint32_t& lanes = m_lane_notes[note];
+		const uint32_t bit = uint32_t(1) << lane;
+
+		if (velocity > 0.0f) {
+			lanes |= bit;
+			setNote(note, velocity);
+		}
+		else if (lanes & bit) {
+			lanes &= ~bit;
+			if (lanes == 0)
+				setNote(note, velocity);
+		}
+	}
+
 	void BaseInstrument::setValues(ParametersValues const& values) {
 		m_values = values;
 	}
@@ -264,7 +310,24 @@ namespace sns {
 		return m_values;
 	}
 
+	Prepared BaseInstrument::prepareValues(ParametersValues const&) {
+		return Prepared();
+	}
+
+	Prepared BaseInstrument::prepareSysex(uint8_t const*, size_t) {
+		return Prepared();
+	}
+
+	void BaseInstrument::takePrepared(Prepared const&) {
+
+	}
+
+	void BaseInstrument::setReclaimer(Reclaimer* reclaimer) {
+		m_reclaimer = reclaimer;
+	}
+
 	void BaseInstrument::panic() {
+		m_lane_notes.fill(0);
 
 	}
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../audio/Audio.hpp"
+#include "../core/Snapshot.hpp"
 
 namespace sns {
 
@@ -8,17 +9,32 @@ namespace sns {
 	using Parameter = int;
 	using ParametersValues = std::map<Parameter, float>;
 
+	// what an instrument derives off the audio thread (a prepared dx7 bank), handed over with the values or the sysex it comes from
+	using Prepared = Snapshot<void>;
 
+	//
+	// Trivially copyable so it goes through lock free queues without allocating, channel messages are
+	// held inline and a sysex points to the arena of the port that received it (valid until the next Midi::take)
+	//
 	struct MidiMessage {
-		InstrumentId instrument;
-		std::vector<unsigned char> bytes;
-		double timestamp;
+		static constexpr int InlineBytes = 3;
+
+		InstrumentId instrument = 0;
+		std::array<uint8_t, InlineBytes> bytes{};
+		uint8_t bytes_size = 0;
+		uint16_t port = 0; // interned port name, Midi::portName
+		double timestamp = 0.0; // host time it was sent at (getCurrentMicroseconds, in seconds), 0 plays it right away
 
-		std::string port;
-		Parameter parameter;
-		float parameter_value;
+		uint8_t const* sysex = nullptr;
+		uint32_t sysex_size = 0;
+		Prepared const* prepared = nullptr; // what the instrument prepared from the sysex, valid as the sysex
+
+		Parameter parameter = 0;
+		float parameter_value = 0.0f;
+
+		uint8_t const* data() const { return sysex ? sysex : bytes.data(); }
+		int size() const { return sysex ? int(sysex_size) : int(bytes_size); }
 	};
-	using MidiMessages = std::vector<MidiMessage>;
 
 	class BaseInstrument {
 	public:
@@ -30,12 +46,27 @@ namespace sns {
 
 		virtual float next();
 
+		// adds the next count samples to output, instruments that render in blocks can override it
+		virtual void render(float* output, int count);
+
 		virtual void setNote(int note, float velocity);
+		// notes of a sequencer pattern lane, instruments without independent lanes layer them: a note is
+		// played when its first lane presses it and released when its last lane does
+		virtual void setLaneNote(int lane, int note, float velocity);
 		virtual void onMidi(MidiMessage const& message);
 
 		virtual void setValues(ParametersValues const& values);
 		ParametersValues getValues() const;
 
+		// values and sysex are prepared on the thread they come from (thread safe, never called on the audio thread),
+		// the audio thread takes what was prepared before setValues or with the message
+		virtual Prepared prepareValues(ParametersValues const& values);
+		virtual Prepared prepareSysex(uint8_t const* data, size_t size);
+		virtual void takePrepared(Prepared const& prepared);
+
+		// where what the audio thread replaces goes, released without it
+		void setReclaimer(Reclaimer* reclaimer);
+
 		void takeMidiControllerUpdates(bool& values, bool& notes);
 		std::set<int> getNotesPressedOnMidiController() const;
 
@@ -52,6 +83,19 @@ namespace sns {
 		void internalTrackMidiNotesReset();
 		std::set<int> m_midi_note_pressed;
 		bool m_midi_updated_note_pressed;
+
+		Reclaimer* m_reclaimer;
+
+		// lanes holding each note (a bit per lane), see setLaneNote
+		std::array<uint32_t, 128> m_lane_notes;
+
+		template <typename T>
+		void retire(Snapshot<T>&& snapshot) {
+			if (m_reclaimer)
+				m_reclaimer->retire(std::move(snapshot));
+			else
+				snapshot.reset();
+		}
 	};
 
 	//
@@ -69,6 +113,8 @@ namespace sns {
 
 	std::string instrumentToString(InstrumentId id);
 	InstrumentId instrumentFromString(std::string const& name);
+	// a new instrument with its default values, nullptr for InstrumentIdNone
+	std::unique_ptr<BaseInstrument> createInstrument(InstrumentId id);
 
 	//
 	// Generic Parameters
@@ -96,6 +142,7 @@ namespace sns {
 	constexpr Parameter ParameterTuning = 19;
 	constexpr Parameter ParameterAccent = 21;
 	constexpr Parameter ParameterVolume = 22;
+	constexpr Parameter ParameterQuality = 23;
 
 
 	// oscillators
@@ -8,11 +8,25 @@ using namespace rosic;
 namespace sns {
 
 	constexpr float PITCH_BEND_OCTAVES = 2.0f;
+	constexpr int LANE_BLOCK = 64;
+	constexpr float LANE_GAIN_TIME = 0.02f; // seconds the headroom takes to follow the lanes playing
 
 	struct TB303::PrivateImplementation {
 		bool do_log;
 		float mod_wheel;
-		Open303 device;
+		std::array<Open303, TB303Lanes> devices;
+
+		// headroom for the lanes summed, 1 / sqrt(lanes playing) eased in so lanes starting and stopping don't click
+		float lane_gain = 1.0f;
+		float lane_gain_coefficient = 1.0f - expf(-1.0f / (LANE_GAIN_TIME * float(SampleRate)));
+		std::array<float, LANE_BLOCK> mix;
+
+		// knobs are shared by the whole rack
+		template <class F>
+		void each(F const& f) {
+			for (auto& device : devices)
+				f(device);
+		}
 	};
 
 	TB303::TB303()
@@ -21,7 +35,7 @@ namespace sns {
 		TAG = "TB303";
 		m->do_log = false;
 
-		m->device.setSampleRate(SampleRate);
+		m->each([](Open303& device) { device.setSampleRate(SampleRate); });
 
 		panic();
 
@@ -34,7 +48,7 @@ namespace sns {
 		BaseInstrument::panic();
 
 		m->mod_wheel = 0.0f;
-		m->device.allNotesOff();
+		m->each([](Open303& device) { device.allNotesOff(); });
 	}
 
 	TB303::~TB303() {
@@ -47,7 +61,7 @@ namespace sns {
 			float value = message.parameter_value * PITCH_BEND_OCTAVES;
 			//Log::d(TAG, sfmt("ParameterPitchBend [%.3f]",  value));
 
-			m->device.setPitchBend(value);
+			m->each([value](Open303& device) { device.setPitchBend(value); });
 
 		}
 		else if (message.parameter == ParameterModulationWheel) {
@@ -63,12 +77,20 @@ namespace sns {
 	}
 
 	void TB303::setNote(int note, float velocity) {
+		setLaneNote(0, note, velocity);
+	}
+
+	void TB303::setLaneNote(int lane, int note, float velocity) {
+		if (lane < 0 || lane >= TB303Lanes)
+			return;
+
+		Open303& device = m->devices[lane];
 		if (velocity > 0.0f) {
 			const int ivelocity = int(velocity * 127.0f);
-			m->device.noteOn(note, ivelocity);
+			device.noteOn(note, ivelocity);
 		}
 		else {
-			m->device.noteOn(note, 0);
+			device.noteOn(note, 0);
 		}
 	}
 
@@ -83,6 +105,7 @@ namespace sns {
 		values[ParameterAccent] = 0.5f;
 		values[ParameterOscBase + ParameterOscKind] = 0.0f;
 		values[ParameterVolume] = 0.5f;
+		values[ParameterQuality] = float(TB303QualityHigh);
 
 		return values;
 	}
@@ -113,34 +136,41 @@ namespace sns {
 
 			if (parameter == ParameterTuning) {
 				float tuning = linearToLinear(value, 0.0f, 1.0f, 400.0f, 480.0f);
-				m->device.setTuning(tuning);
+				m->each([tuning](Open303& device) { device.setTuning(tuning); });
 			}
 			else if (parameter == (ParameterFilterBase + ParameterFilterCutoff)) {
 				float cutoff = linearToExponential(value, 0.0f, 1.0f, 314.0f, 2394.0f);
-				m->device.setCutoff(cutoff);
+				m->each([cutoff](Open303& device) { device.setCutoff(cutoff); });
 			}
 			else if (parameter == (ParameterFilterBase + ParameterFilterResonance)) {
 				float resonance = linearToLinear(value, 0.0f, 1.0f, 0.0f, 100.0f);
-				m->device.setResonance(resonance);
+				m->each([resonance](Open303& device) { device.setResonance(resonance); });
 			}
 			else if (parameter == (ParameterEnvBase + ParameterEnvMod)) {
 				needs_to_update_modulation = true;
 			}
 			else if (parameter == (ParameterEnvBase + ParameterEnvDecay)) {
 				float decay = linearToExponential(value, 0.0f, 1.0f, 200.0f, 2000.0f);
-				m->device.setDecay(decay);
+				m->each([decay](Open303& device) { device.setDecay(decay); });
 			}
 			else if (parameter == ParameterAccent) {
 				float accent = linearToLinear(value, 0.0f, 1.0f, 0.0f, 100.0f);
-				m->device.setAccent(accent);
+				m->each([accent](Open303& device) { device.setAccent(accent); });
 			}
 			else if (parameter == ParameterVolume) {
 				float volume = linearToLinear(value, 0.0f, 1.0f, -60.0f, 0.0f);
-				m->device.setVolume(volume);
+				m->each([volume](Open303& device) { device.setVolume(volume); });
 			}
 			else if (parameter == (ParameterOscBase + ParameterOscKind)) {
 				double waveform = double(clampTo(value, 0.0f, 1.0f));
-				m->device.setWaveform(waveform);
+				m->each([waveform](Open303& device) { device.setWaveform(waveform); });
+			}
+			else if (parameter == ParameterQuality) {
+				int quality = clampTo(int(value), TB303QualityLow, TB303QualityHigh);
+				m->each([quality](Open303& device) {
+					device.setOversampling(quality == TB303QualityLow ? 1 : (quality == TB303QualityMedium ? 2 : 4));
+					device.setSinglePrecision(quality != TB303QualityHigh);
+				});
 			}
 		}
 
@@ -152,9 +182,35 @@ namespace sns {
 	}
 
 	float TB303::next() {
-		double sample = m->device.getSample();
+		float sample = 0.0f;
+		render(&sample, 1);
+		return sample;
+	}
+
+	void TB303::render(float* output, int count) {
+		while (count) {
+			const int block = minimum(count, LANE_BLOCK);
+			count -= block;
+
+			// a lane at a time, the ones with nothing to play (Open303 goes idle once its envelope ended) are skipped
+			int playing = 0;
+			std::fill_n(m->mix.begin(), block, 0.0f);
+			for (auto& device : m->devices) {
+				if (device.isIdle())
+					continue;
+
+				playing++;
+				for (int i = 0; i != block; ++i)
+					m->mix[i] += float(device.getSample());
+			}
 
-		return float(sample);
+			const float target = (playing > 1) ? 1.0f / sqrtf(float(playing)) : 1.0f;
+			for (int i = 0; i != block; ++i) {
+				m->lane_gain += (target - m->lane_gain) * m->lane_gain_coefficient;
+				output[i] += m->mix[i] * m->lane_gain;
+			}
+			output += block;
+		}
 	}
 
 	void TB303::updateEnvelopModulation() {
@@ -162,7 +218,7 @@ namespace sns {
 		value = clampTo(value, 0.0f, 1.0f);
 
 		float env_mod = linearToLinear(value, 0.0f, 1.0f, 0.0f, 100.0f);
-		m->device.setEnvMod(env_mod);
+		m->each([env_mod](Open303& device) { device.setEnvMod(env_mod); });
 	}
 
 }
\ No newline at end of file
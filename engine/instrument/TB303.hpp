@@ -4,6 +4,14 @@
 
 namespace sns {
 
+	// values for ParameterQuality
+	constexpr int TB303QualityLow = 0;		// no oversampling, single precision
+	constexpr int TB303QualityMedium = 1;	// 2x oversampling, single precision
+	constexpr int TB303QualityHigh = 2;		// 4x oversampling, double precision (the original Open303)
+
+	// independent Open303 instances, one per sequencer lane (midi and the keyboard play the first one)
+	constexpr int TB303Lanes = 4;
+
 	class TB303 : public BaseInstrument {
 	public:
 		TB303();
@@ -14,8 +22,10 @@ namespace sns {
 
 		void onMidi(MidiMessage const& message) override;
 		void setNote(int note, float velocity) override;
+		void setLaneNote(int lane, int note, float velocity) override;
 
 		float next() override;
+		void render(float* output, int count) override;
 		void panic() override;
 	private:
 		struct PrivateImplementation;
@@ -0,0 +1,301 @@
+#include "DrumFont.hpp"
+#include "../../core/Log.hpp"
+
+#define TML_IMPLEMENTATION
+#include "tsf/tml.h"
+
+#define TSF_IMPLEMENTATION
+#include "tsf/tsf.h"
+
+namespace sns {
+
+	DrumFont::~DrumFont() {
+		if (sound_font)
+			tsf_close(sound_font);
+	}
+
+	//
+	// General midi fonts start with melodic programs, the drum kits are in bank 128.
+	// The standard kit, else the first kit, else the first preset (drum only fonts as the embedded one)
+	//
+	static int kitPreset(tsf* font) {
+		int index = tsf_get_presetindex(font, 128, 0);
+		if (index >= 0)
+			return index;
+
+		for (int p = 0; p != font->presetNum; ++p)
+			if (font->presets[p].bank == 128)
+				return p;
+
+		return 0;
+	}
+
+	//
+	// A DrumSample for every key of every region of the kit preset, playing the region as a tsf voice would.
+	// Fonts using loops or modulators (lfos, mod envelope) are left to tsf.
+	//
+	static std::vector<DrumSample> buildDrumSamples(tsf* font, int kit, uint8_t const* pcm, uint32_t frames) {
+		std::vector<DrumSample> samples;
+
+		if (font == nullptr || kit >= font->presetNum)
+			return samples;
+
+		tsf_preset const& preset = font->presets[kit];
+
+		for (int r = 0; r != preset.regionNum; ++r) {
+			tsf_region const& region = preset.regions[r];
+
+			bool one_shot = (region.loop_mode == TSF_LOOPMODE_NONE || region.loop_start >= region.loop_end);
+			bool static_voice = !region.modEnvToPitch && !region.modEnvToFilterFc &&
+				!region.modLfoToPitch && !region.modLfoToFilterFc && !region.modLfoToVolume &&
+				!region.vibLfoToPitch;
+
+			if (!one_shot || !static_voice)
+				return std::vector<DrumSample>();
+		}
+
+		for (int r = 0; r != preset.regionNum; ++r) {
+			tsf_region const& region = preset.regions[r];
+
+			// lowpass, as tsf_voice_note_on
+			struct tsf_voice_lowpass lowpass;
+			float lowpass_fc = (region.initialFilterFc <= 13500 ? tsf_cents2Hertz((float)region.initialFilterFc) / font->outSampleRate : 1.0f);
+			lowpass.QInv = 1.0 / TSF_POW(10.0, ((region.initialFilterQ / 10.0f) / 20.0));
+			lowpass.active = (lowpass_fc < 0.499f);
+			if (lowpass.active)
+				tsf_voice_lowpass_setup(&lowpass, lowpass_fc);
+
+			for (int key = region.lokey; key <= region.hikey && key < 128; ++key) {
+				// pitch, as tsf_voice_calcpitchratio
+				double note = key + region.transpose + region.tune / 100.0;
+				double adjusted_pitch = region.pitch_keycenter + (note - region.pitch_keycenter) * (region.pitch_keytrack / 100.0);
+				double pitch_output_factor = region.sample_rate / (tsf_timecents2Secsd(region.pitch_keycenter * 100.0) * font->outSampleRate);
+
+				// envelope, as tsf_voice_envelope_setup
+				tsf_envelope env = region.ampenv;
+				if (env.keynumToHold) {
+					env.hold += env.keynumToHold * (60.0f - key);
+					env.hold = (env.hold < -10000.0f ? 0.0f : tsf_timecents2Secsf(env.hold));
+				}
+				if (env.keynumToDecay) {
+					env.decay += env.keynumToDecay * (60.0f - key);
+					env.decay = (env.decay < -10000.0f ? 0.0f : tsf_timecents2Secsf(env.decay));
+				}
+
+				DrumSample sample;
+				sample.key = key;
+				sample.lovel = region.lovel;
+				sample.hivel = region.hivel;
+				sample.group = int(region.group);
+				sample.attenuation = region.attenuation;
+				sample.delay = env.delay;
+				sample.attack = env.attack;
+				sample.hold = env.hold;
+				sample.decay = env.decay;
+				sample.sustain = env.sustain;
+				sample.release = env.release;
+
+				sample.pcm = pcm;
+				sample.frames = frames;
+				sample.offset = region.offset;
+				sample.end = minimum(region.end, frames);
+				sample.pitch_ratio = tsf_timecents2Secsd(adjusted_pitch * 100.0) * pitch_output_factor;
+
+				sample.lowpass = lowpass.active;
+				if (sample.lowpass) {
+					sample.a0 = lowpass.a0;
+					sample.a1 = lowpass.a1;
+					sample.b1 = lowpass.b1;
+					sample.b2 = lowpass.b2;
+				}
+				samples.push_back(sample);
+			}
+		}
+
+		return samples;
+	}
+
+	//
+	// tsf_load converts the whole smpl chunk to floats.
+	// Here only the hydra is parsed, the frames stay in data (the file mapping or the embedded kit) where the native voices read them,
+	// pcm and frames are set to the smpl chunk.
+	//
+	static tsf* loadMappedSoundFont(uint8_t const* data, size_t size, uint8_t const*& pcm, uint32_t& frames) {
+		if (size > size_t(UINT32_MAX))
+			return nullptr;
+
+		struct tsf_stream_memory memory = { (const char*)data, (unsigned int)size, 0 };
+		struct tsf_stream stream = { &memory, (int(*)(void*, void*, unsigned int))&tsf_stream_memory_read, (int(*)(void*, unsigned int))&tsf_stream_memory_skip };
+
+		struct tsf_riffchunk chunk_head, chunk_list, chunk;
+		if (!tsf_riffchunk_read(TSF_NULL, &chunk_head, &stream) || !TSF_FourCCEquals(chunk_head.id, "sfbk"))
+			return nullptr;
+
+		struct tsf_hydra hydra;
+		memset(&hydra, 0, sizeof(hydra));
+
+		pcm = nullptr;
+		frames = 0;
+		bool good = true;
+
+		while (good && tsf_riffchunk_read(&chunk_head, &chunk_list, &stream)) {
+			if (TSF_FourCCEquals(chunk_list.id, "pdta")) {
+				while (good && tsf_riffchunk_read(&chunk_list, &chunk, &stream)) {
+					#define HandleChunk(chunkName) (TSF_FourCCEquals(chunk.id, #chunkName) && !(chunk.size % chunkName##SizeInFile)) \
+						{ \
+							int num = chunk.size / chunkName##SizeInFile; \
+							hydra.chunkName##Num = num; \
+							hydra.chunkName##s = (struct tsf_hydra_##chunkName*)TSF_MALLOC(num * sizeof(struct tsf_hydra_##chunkName)); \
+							good = (hydra.chunkName##s != nullptr); \
+							for (int i = 0; good && i < num; ++i) tsf_hydra_read_##chunkName(&hydra.chunkName##s[i], &stream); \
+						}
+					enum {
+						phdrSizeInFile = 38, pbagSizeInFile = 4, pmodSizeInFile = 10,
+						pgenSizeInFile = 4, instSizeInFile = 22, ibagSizeInFile = 4,
+						imodSizeInFile = 10, igenSizeInFile = 4, shdrSizeInFile = 46
+					};
+					if HandleChunk(phdr) else if HandleChunk(pbag) else if HandleChunk(pmod)
+					else if HandleChunk(pgen) else if HandleChunk(inst) else if HandleChunk(ibag)
+					else if HandleChunk(imod) else if HandleChunk(igen) else if HandleChunk(shdr)
+					else stream.skip(stream.data, chunk.size);
+					#undef HandleChunk
+				}
+			}
+			else if (TSF_FourCCEquals(chunk_list.id, "sdta")) {
+				while (tsf_riffchunk_read(&chunk_list, &chunk, &stream)) {
+					if (TSF_FourCCEquals(chunk.id, "smpl") && !pcm && chunk.size >= sizeof(short) && memory.pos + chunk.size <= memory.total) {
+						pcm = data + memory.pos;
+						frames = chunk.size / sizeof(short);
+					}
+					stream.skip(stream.data, chunk.size);
+				}
+			}
+			else {
+				stream.skip(stream.data, chunk_list.size);
+			}
+		}
+
+		tsf* res = nullptr;
+
+		if (good && pcm && hydra.phdrs && hydra.pbags && hydra.pmods && hydra.pgens && hydra.insts &&
+			hydra.ibags && hydra.imods && hydra.igens && hydra.shdrs) {
+
+			res = (tsf*)TSF_MALLOC(sizeof(tsf));
+			if (res) {
+				memset(res, 0, sizeof(tsf));
+				res->outSampleRate = 44100.0f;
+
+				if (!tsf_load_presets(res, &hydra, frames)) {
+					TSF_FREE(res);
+					res = nullptr;
+				}
+			}
+		}
+
+		TSF_FREE(hydra.phdrs); TSF_FREE(hydra.pbags); TSF_FREE(hydra.pmods);
+		TSF_FREE(hydra.pgens); TSF_FREE(hydra.insts); TSF_FREE(hydra.ibags);
+		TSF_FREE(hydra.imods); TSF_FREE(hydra.igens); TSF_FREE(hydra.shdrs);
+
+		return res;
+	}
+
+	//
+	// Fonts the native voices can't play are rendered by tsf, which needs float frames.
+	// Only the ranges of the kit preset are decoded, packed one after the other with its regions moved onto them,
+	// the other presets are never played and lose their regions.
+	//
+	static bool decodeKitPreset(tsf* font, int kit, uint8_t const* pcm, uint32_t frames) {
+		if (kit >= font->presetNum)
+			return false;
+
+		for (int p = 0; p != font->presetNum; ++p)
+			if (p != kit)
+				font->presets[p].regionNum = 0;
+
+		tsf_preset& preset = font->presets[kit];
+
+		// regions sharing a sample share its frames, one extra frame as voices interpolate with the frame after the end
+		std::map<std::pair<unsigned int, unsigned int>, unsigned int> ranges;
+		size_t count = 0;
+		for (int r = 0; r != preset.regionNum; ++r) {
+			tsf_region const& region = preset.regions[r];
+			auto [current, inserted] = ranges.try_emplace({ region.offset, minimum(region.end + 1, frames) }, (unsigned int)count);
+			if (inserted && current->first.second > current->first.first)
+				count += current->first.second - current->first.first;
+		}
+
+		float* decoded = (float*)TSF_MALLOC((count + 1) * sizeof(float));
+		if (decoded == nullptr)
+			return false;
+
+		for (auto const& [range, start] : ranges)
+			for (unsigned int i = range.first; i < range.second; ++i) {
+				uint8_t const* frame = pcm + size_t(i) * 2;
+				decoded[start + i - range.first] = float(int16_t(uint16_t(frame[0]) | (uint16_t(frame[1]) << 8)) / 32767.0);
+			}
+		decoded[count] = 0.0f;
+
+		for (int r = 0; r != preset.regionNum; ++r) {
+			tsf_region& region = preset.regions[r];
+			unsigned int start = ranges[{ region.offset, minimum(region.end + 1, frames) }];
+
+			region.loop_start = clampTo(region.loop_start, region.offset, region.end) - region.offset + start;
+			region.loop_end = clampTo(region.loop_end, region.offset, region.end) - region.offset + start;
+			region.end = region.end - region.offset + start;
+			region.offset = start;
+		}
+
+		font->fontSamples = decoded;
+		return true;
+	}
+
+	static bool prepareDrumFont(DrumFont& font, uint8_t const* pcm, uint32_t frames) {
+		tsf_set_output(font.sound_font, TSFOutputMode::TSF_MONO, sns::SampleRate, 0);
+
+		// creates the channel now, so pitch bending never allocates on the audio thread
+		tsf_channel_set_pitchwheel(font.sound_font, 0, 8192);
+
+		font.preset = kitPreset(font.sound_font);
+		font.voices.setSamples(buildDrumSamples(font.sound_font, font.preset, pcm, frames));
+
+		if (!font.voices.empty())
+			return true;
+
+		Log::i("DrumMachine", sfmt("Font not playable by the native voices, using tsf (preset %d)", font.preset));
+		return decodeKitPreset(font.sound_font, font.preset, pcm, frames);
+	}
+
+	std::unique_ptr<DrumFont> DrumFont::open(std::string const& filename) {
+		auto font = std::make_unique<DrumFont>();
+		font->file = std::make_unique<MappedFile>();
+
+		if (!font->file->open(filename)) {
+			Log::e("DrumMachine", sfmt("Unable to open sound font %s", filename));
+			return nullptr;
+		}
+
+		uint8_t const* pcm = nullptr;
+		uint32_t frames = 0;
+		font->sound_font = loadMappedSoundFont(font->file->data(), font->file->size(), pcm, frames);
+		if (font->sound_font == nullptr || !prepareDrumFont(*font, pcm, frames)) {
+			Log::e("DrumMachine", sfmt("Invalid sound font %s", filename));
+			return nullptr;
+		}
+
+		Log::i("DrumMachine", sfmt("Loaded sound font %s, kit %s", filename, tsf_get_presetname(font->sound_font, font->preset)));
+		return font;
+	}
+
+	std::unique_ptr<DrumFont> DrumFont::fromMemory(void const* data, size_t size) {
+		auto font = std::make_unique<DrumFont>();
+
+		uint8_t const* pcm = nullptr;
+		uint32_t frames = 0;
+		font->sound_font = loadMappedSoundFont((uint8_t const*)data, size, pcm, frames);
+		if (font->sound_font == nullptr || !prepareDrumFont(*font, pcm, frames))
+			return nullptr;
+
+		font->voices.prepareAll();
+		return font;
+	}
+}
\ No newline at end of file
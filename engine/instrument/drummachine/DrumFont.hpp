@@ -0,0 +1,34 @@
+#pragma once
+
+#include "DrumVoices.hpp"
+#include "../../core/MappedFile.hpp"
+
+struct tsf;
+
+namespace sns {
+
+	//
+	// A loaded font, everything the audio thread renders from
+	//
+	struct DrumFont {
+		std::unique_ptr<MappedFile> file; // user fonts, the voices read their frames from the mapping
+		tsf* sound_font = nullptr;
+		int preset = 0; // the kit played, the standard drum kit (bank 128) of general midi fonts
+
+		// native one-shot player, tsf is only rendered when the font can't be played by it
+		DrumVoices voices;
+
+		DrumFont() = default;
+		~DrumFont();
+
+		DrumFont(DrumFont const&) = delete;
+		DrumFont& operator=(DrumFont const&) = delete;
+
+		// a font in memory (the embedded kit), played from data which has to outlive it, nullptr when it is not a valid font.
+		// Every one-shot is rendered right away
+		static std::unique_ptr<DrumFont> fromMemory(void const* data, size_t size);
+		// a user font read from a mapping of the file, nullptr when it can't be opened or is not a valid font.
+		// One-shots are rendered once hit, by whoever calls voices.prepareRequested
+		static std::unique_ptr<DrumFont> open(std::string const& filename);
+	};
+}
\ No newline at end of file
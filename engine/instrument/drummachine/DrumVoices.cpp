@@ -0,0 +1,401 @@
+#include "DrumVoices.hpp"
+
+#include <cstring>
+#include <map>
+#include <tuple>
+
+namespace sns {
+
+	constexpr float FAST_RELEASE_TIME = 0.01f; // grace release for choked voices (avoid clicks)
+	constexpr float OUTPUT_RATE = float(SampleRate);
+
+	static float decibelsToGain(float db) { return (db > -100.f ? powf(10.0f, db * 0.05f) : 0); }
+	static float gainToDecibels(float gain) { return (gain <= .00001f ? -100.f : (float)(20.0 * log10(gain))); }
+
+	// out += in * gain, kept branch free so the compiler vectorizes it
+	static void accumulate(float* __restrict output, float const* __restrict input, float gain, int count) {
+		for (int i = 0; i != count; ++i)
+			output[i] += input[i] * gain;
+	}
+
+	// a frame of the font as tsf decodes it, the frame after the last one reads as silence
+	static float frame(DrumSample const& sample, uint32_t index) {
+		if (index >= sample.frames)
+			return 0.0f;
+
+		uint8_t const* data = sample.pcm + size_t(index) * 2;
+		return float(int16_t(uint16_t(data[0]) | (uint16_t(data[1]) << 8)) / 32767.0);
+	}
+
+	// the font at position through the lowpass of the region, as tsf_voice_render
+	static float read(DrumSample const& sample, double position, double& z1, double& z2) {
+		const uint32_t index = uint32_t(position);
+		const float alpha = float(position - double(index));
+		float value = frame(sample, index) * (1.0f - alpha) + frame(sample, index + 1) * alpha;
+
+		if (sample.lowpass) {
+			const double in = value;
+			const double out = in * sample.a0 + z1;
+			z1 = in * sample.a1 + z2 - sample.b1 * out;
+			z2 = in * sample.a0 - sample.b2 * out;
+			value = float(out);
+		}
+
+		return value;
+	}
+
+	static void renderOneShot(DrumSample const& sample, std::vector<float>& data) {
+		double position = double(sample.offset);
+		const double end = double(sample.end);
+		double z1 = 0.0;
+		double z2 = 0.0;
+
+		data.clear();
+		data.reserve(size_t((end - position) / sample.pitch_ratio) + 1);
+
+		while (position < end) {
+			data.push_back(read(sample, position, z1, z2));
+			position += sample.pitch_ratio;
+		}
+	}
+
+	int DrumVoices::defaultChokeGroup(int key) {
+		switch (key) {
+			// tr808 closed / open hihat
+		case 54: case 56: return 1001;
+
+			// tr909 closed / hihat / open hihat
+		case 78: case 80: case 82: return 1002;
+
+		default: return 0;
+		}
+	}
+
+	DrumVoices::DrumVoices()
+		:m_play_index(0),
+		m_global_gain_db(0.0f),
+		m_pitch_ratio(1.0)
+	{
+	}
+
+	void DrumVoices::setSamples(std::vector<DrumSample> const& samples) {
+		reset();
+
+		m_samples = samples;
+		for (auto& current : m_key_samples)
+			current.clear();
+
+		m_rendered.clear();
+		m_sample_rendered.assign(m_samples.size(), -1);
+
+		// keys without key tracking play the same frames at the same pitch
+		std::map<std::tuple<uint8_t const*, uint32_t, uint32_t, double, bool, double, double, double, double>, int> shared;
+
+		for (int i = 0; i != int(m_samples.size()); ++i) {
+			DrumSample const& sample = m_samples[i];
+			if (sample.key < 0 || sample.key >= 128 || !sample.pcm || sample.end <= sample.offset)
+				continue;
+
+			auto [found, inserted] = shared.try_emplace(std::make_tuple(sample.pcm, sample.offset, sample.end, sample.pitch_ratio,
+				sample.lowpass, sample.a0, sample.a1, sample.b1, sample.b2), int(m_rendered.size()));
+			if (inserted) {
+				m_rendered.push_back(std::make_unique<Rendered>());
+				m_rendered.back()->source = &sample;
+			}
+
+			m_sample_rendered[i] = found->second;
+			m_key_samples[sample.key].push_back(i);
+		}
+	}
+
+	bool DrumVoices::empty() const {
+		return m_samples.empty();
+	}
+
+	void DrumVoices::prepareAll() {
+		for (auto& rendered : m_rendered) {
+			if (rendered->state.load(std::memory_order_acquire) == Ready)
+				continue;
+
+			renderOneShot(*rendered->source, rendered->data);
+			rendered->state.store(Ready, std::memory_order_release);
+		}
+	}
+
+	bool DrumVoices::prepareRequested() {
+		bool prepared = false;
+
+		for (auto& rendered : m_rendered) {
+			if (rendered->state.load(std::memory_order_acquire) != Requested)
+				continue;
+
+			renderOneShot(*rendered->source, rendered->data);
+			rendered->state.store(Ready, std::memory_order_release);
+			prepared = true;
+		}
+
+		return prepared;
+	}
+
+	void DrumVoices::setVolume(float volume) {
+		m_global_gain_db = (volume == 1.0f ? 0 : -gainToDecibels(1.0f / volume));
+	}
+
+	void DrumVoices::setPitchBend(float semitones) {
+		m_pitch_ratio = pow(2.0, double(semitones) / 12.0);
+	}
+
+	void DrumVoices::reset() {
+		for (auto& voice : m_voices)
+			voice.playing = false;
+	}
+
+	DrumVoices::Voice* DrumVoices::allocate(int group) {
+		Voice* free = nullptr;
+
+		for (auto& voice : m_voices) {
+			if (!voice.playing) {
+				if (!free)
+					free = &voice;
+			}
+			else if (group != 0 && voice.group == group) {
+				// choke, quick release
+				voice.env.release = 0.0f;
+				nextSegment(voice, Segment::Sustain);
+			}
+		}
+
+		if (free)
+			return free;
+
+		// steal the oldest
+		Voice* oldest = &m_voices[0];
+		for (auto& voice : m_voices)
+			if (voice.play_index < oldest->play_index)
+				oldest = &voice;
+		return oldest;
+	}
+
+	void DrumVoices::noteOn(int key, float velocity) {
+		if (key < 0 || key >= 128)
+			return;
+
+		if (velocity <= 0.0f) {
+			noteOff(key);
+			return;
+		}
+
+		const int midi_velocity = int(velocity * 127);
+		const uint32_t play_index = m_play_index++;
+
+		for (int index : m_key_samples[key]) {
+			DrumSample const& sample = m_samples[index];
+			if (midi_velocity < sample.lovel || midi_velocity > sample.hivel)
+				continue;
+
+			const int group = (sample.group != 0) ? sample.group : defaultChokeGroup(key);
+
+			Voice* voice = allocate(group);
+			voice->playing = true;
+			voice->key = key;
+			voice->group = group;
+			voice->play_index = play_index;
+			voice->sample = &sample;
+
+			// the first hit of a one-shot asks for it to be rendered
+			Rendered& rendered = *m_rendered[m_sample_rendered[index]];
+			int state = rendered.state.load(std::memory_order_acquire);
+			if (state == Idle)
+				rendered.state.compare_exchange_strong(state, Requested);
+
+			voice->data = (state == Ready) ? &rendered.data : nullptr;
+			voice->position = voice->data ? 0.0 : double(sample.offset);
+			voice->z1 = voice->z2 = 0.0;
+			voice->gain = decibelsToGain(m_global_gain_db - sample.attenuation - gainToDecibels(1.0f / velocity));
+
+			voice->env.release = sample.release;
+			nextSegment(*voice, Segment::None);
+		}
+	}
+
+	void DrumVoices::noteOff(int key) {
+		// release the oldest hit of this key that is not yet releasing
+		Voice* first = nullptr;
+		for (auto& voice : m_voices) {
+			if (!voice.playing || voice.key != key || voice.env.segment >= Segment::Release)
+				continue;
+			if (!first || voice.play_index < first->play_index)
+				first = &voice;
+		}
+
+		if (!first)
+			return;
+
+		const uint32_t play_index = first->play_index;
+		for (auto& voice : m_voices)
+			if (voice.playing && voice.key == key && voice.play_index == play_index && voice.env.segment < Segment::Release)
+				nextSegment(voice, Segment::Sustain);
+	}
+
+	void DrumVoices::render(float* output, int count) {
+		memset(output, 0, sizeof(float) * count);
+
+		for (auto& voice : m_voices)
+			if (voice.playing)
+				renderVoice(voice, output, count);
+	}
+
+	void DrumVoices::renderVoice(Voice& voice, float* output, int count) {
+		if (voice.data == nullptr) {
+			renderVoiceFromFont(voice, output, count);
+			return;
+		}
+
+		std::vector<float> const& data = *voice.data;
+		const double end = double(data.size());
+
+		while (count) {
+			const int block = minimum(count, Block);
+			count -= block;
+
+			const float gain = voice.gain * voice.env.level;
+			processEnvelope(voice, block);
+
+			if (m_pitch_ratio == 1.0) {
+				size_t position = size_t(voice.position);
+				int available = int(minimum(size_t(block), data.size() - position));
+
+				accumulate(output, data.data() + position, gain, available);
+				voice.position += double(available);
+			}
+			else {
+				// pitch bent, read in between the rendered samples
+				for (int i = 0; i != block && voice.position < end; ++i) {
+					size_t position = size_t(voice.position);
+					size_t next = minimum(position + 1, data.size() - 1);
+					float alpha = float(voice.position - double(position));
+
+					output[i] += (data[position] * (1.0f - alpha) + data[next] * alpha) * gain;
+					voice.position += m_pitch_ratio;
+				}
+			}
+			output += block;
+
+			if (voice.position >= end || voice.env.segment == Segment::Done) {
+				voice.playing = false;
+				return;
+			}
+		}
+	}
+
+	void DrumVoices::renderVoiceFromFont(Voice& voice, float* output, int count) {
+		DrumSample const& sample = *voice.sample;
+		const double end = double(sample.end);
+		const double pitch_ratio = sample.pitch_ratio * m_pitch_ratio;
+
+		while (count) {
+			const int block = minimum(count, Block);
+			count -= block;
+
+			const float gain = voice.gain * voice.env.level;
+			processEnvelope(voice, block);
+
+			for (int i = 0; i != block && voice.position < end; ++i) {
+				output[i] += read(sample, voice.position, voice.z1, voice.z2) * gain;
+				voice.position += pitch_ratio;
+			}
+			output += block;
+
+			if (voice.position >= end || voice.env.segment == Segment::Done) {
+				voice.playing = false;
+				return;
+			}
+		}
+	}
+
+	void DrumVoices::processEnvelope(Voice& voice, int count) {
+		Envelope& e = voice.env;
+
+		if (e.slope) {
+			if (e.exponential) e.level *= powf(e.slope, (float)count);
+			else e.level += (e.slope * count);
+		}
+
+		if ((e.samples_until_next -= count) <= 0)
+			nextSegment(voice, e.segment);
+	}
+
+	void DrumVoices::nextSegment(Voice& voice, Segment active) {
+		Envelope& e = voice.env;
+		DrumSample const& p = *voice.sample;
+
+		switch (active) {
+		case Segment::None:
+			e.samples_until_next = int(p.delay * OUTPUT_RATE);
+			if (e.samples_until_next > 0) {
+				e.segment = Segment::Delay;
+				e.exponential = false;
+				e.level = 0.0f;
+				e.slope = 0.0f;
+				return;
+			}
+			[[fallthrough]];
+		case Segment::Delay:
+			e.samples_until_next = int(p.attack * OUTPUT_RATE);
+			if (e.samples_until_next > 0) {
+				e.segment = Segment::Attack;
+				e.exponential = false;
+				e.level = 0.0f;
+				e.slope = 1.0f / e.samples_until_next;
+				return;
+			}
+			[[fallthrough]];
+		case Segment::Attack:
+			e.samples_until_next = int(p.hold * OUTPUT_RATE);
+			if (e.samples_until_next > 0) {
+				e.segment = Segment::Hold;
+				e.exponential = false;
+				e.level = 1.0f;
+				e.slope = 0.0f;
+				return;
+			}
+			[[fallthrough]];
+		case Segment::Hold:
+			e.samples_until_next = int(p.decay * OUTPUT_RATE);
+			if (e.samples_until_next > 0) {
+				// same exponential decay as TinySoundFont (and LinuxSampler)
+				const float slope = -9.226f / e.samples_until_next;
+				e.segment = Segment::Decay;
+				e.level = 1.0f;
+				e.slope = expf(slope);
+				e.exponential = true;
+				if (p.sustain > 0.0f)
+					e.samples_until_next = int(log(p.sustain) / slope);
+				return;
+			}
+			[[fallthrough]];
+		case Segment::Decay:
+			e.segment = Segment::Sustain;
+			e.level = p.sustain;
+			e.slope = 0.0f;
+			e.samples_until_next = 0x7FFFFFFF;
+			e.exponential = false;
+			return;
+		case Segment::Sustain:
+		{
+			e.segment = Segment::Release;
+			e.samples_until_next = int((e.release <= 0 ? FAST_RELEASE_TIME : e.release) * OUTPUT_RATE);
+			const float slope = -9.226f / e.samples_until_next;
+			e.slope = expf(slope);
+			e.exponential = true;
+			return;
+		}
+		case Segment::Release:
+		default:
+			e.segment = Segment::Done;
+			e.exponential = false;
+			e.level = e.slope = 0.0f;
+			e.samples_until_next = 0x7FFFFFF;
+		}
+	}
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "../../audio/Audio.hpp"
+
+#include <atomic>
+
+namespace sns {
+
+	//
+	// A one-shot of a font played on a key: where its 16 bit frames are in the font, with the pitch and lowpass of its region.
+	// The voices play it rendered once to the engine rate
+	//
+	struct DrumSample {
+		int key = 0;
+		int lovel = 0;		// midi velocity range
+		int hivel = 127;
+		int group = 0;		// choke group, 0 for none
+		float attenuation = 0.0f; // dB
+
+		// amp envelope, times in seconds, sustain as gain
+		float delay = 0.0f;
+		float attack = 0.0f;
+		float hold = 0.0f;
+		float decay = 0.0f;
+		float sustain = 1.0f;
+		float release = 0.0f;
+
+		// little endian 16 bit frames of the font (the file mapping), played from offset up to end
+		uint8_t const* pcm = nullptr;
+		uint32_t frames = 0;
+		uint32_t offset = 0;
+		uint32_t end = 0;
+		double pitch_ratio = 1.0; // font frames per output sample
+
+		// static lowpass, coefficients as tsf_voice_lowpass_setup
+		bool lowpass = false;
+		double a0 = 0.0;
+		double a1 = 0.0;
+		double b1 = 0.0;
+		double b2 = 0.0;
+	};
+
+	//
+	// Plays DrumSamples, mirroring TinySoundFont's voice behaviour (per block envelopes, note off and exclusive classes)
+	// without any per voice region lookup, resampling or filtering on the audio thread: hits mix one-shots already
+	// rendered to the engine rate. Rendering is eager (prepareAll) or lazy (prepareRequested), until a one-shot is
+	// ready its hits are played from the font frames
+	//
+	class DrumVoices {
+	public:
+		static constexpr int MaxVoices = 32;
+		static constexpr int Block = 64;
+
+		DrumVoices();
+
+		void setSamples(std::vector<DrumSample> const& samples);
+		bool empty() const;
+
+		// render the one-shots, never on the audio thread: every one of them, or those hit since the last call.
+		// prepareRequested returns false when none was waiting
+		void prepareAll();
+		bool prepareRequested();
+
+		void setVolume(float volume);
+		void setPitchBend(float semitones);
+
+		void noteOn(int key, float velocity);
+		void noteOff(int key);
+		void reset();
+
+		// overwrites output with count samples
+		void render(float* output, int count);
+
+		// the choke group used for keys the font does not put in an exclusive class (hihats)
+		static int defaultChokeGroup(int key);
+	private:
+		enum class Segment { None, Delay, Attack, Hold, Decay, Sustain, Release, Done };
+		enum RenderState { Idle, Requested, Ready };
+
+		// a one-shot at the engine rate, shared by the keys playing the same frames at the same pitch
+		struct Rendered {
+			DrumSample const* source = nullptr;
+			std::atomic<int> state{ Idle };
+			std::vector<float> data; // written before the state turns Ready, never after
+		};
+
+		struct Envelope {
+			Segment segment = Segment::Done;
+			float level = 0.0f;
+			float slope = 0.0f;
+			int samples_until_next = 0;
+			bool exponential = false;
+			float release = 0.0f;
+		};
+
+		struct Voice {
+			bool playing = false;
+			int key = 0;
+			int group = 0;
+			uint32_t play_index = 0;
+			float gain = 0.0f;
+			double position = 0.0; // in the rendered one-shot, in the font frames without it
+			double z1 = 0.0; // lowpass state, playing from the font frames
+			double z2 = 0.0;
+			DrumSample const* sample = nullptr;
+			std::vector<float> const* data = nullptr; // the rendered one-shot, nullptr while it is not ready
+			Envelope env;
+		};
+
+		std::vector<DrumSample> m_samples;
+		std::array<std::vector<int>, 128> m_key_samples; // key -> index in m_samples
+		std::vector<std::unique_ptr<Rendered>> m_rendered;
+		std::vector<int> m_sample_rendered; // index in m_samples -> index in m_rendered
+		std::array<Voice, MaxVoices> m_voices;
+		uint32_t m_play_index;
+		float m_global_gain_db;
+		double m_pitch_ratio;
+
+		void nextSegment(Voice& voice, Segment active);
+		void processEnvelope(Voice& voice, int count);
+		void renderVoice(Voice& voice, float* output, int count);
+		void renderVoiceFromFont(Voice& voice, float* output, int count);
+		Voice* allocate(int group);
+	};
+}
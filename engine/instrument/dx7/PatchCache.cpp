@@ -0,0 +1,112 @@
+#include "PatchCache.hpp"
+#include "patch.h"
+#include "env.h"
+#include "dx7note.h"
+
+namespace dx7 {
+
+	void PreparePatch(const char unpacked[156], TuningState& tuning, PreparedPatch& prepared) {
+		const uint8_t* patch = (const uint8_t*)unpacked;
+
+		memcpy(prepared.unpacked, unpacked, 156);
+		memcpy(prepared.name, unpacked + 145, 10);
+		prepared.name[10] = 0;
+
+		for (int op = 0; op < 6; op++) {
+			int off = op * 21;
+
+			for (int i = 0; i < 4; i++) {
+				prepared.rates[op][i] = patch[off + i];
+				prepared.levels[op][i] = patch[off + 4 + i];
+			}
+
+			int mode = patch[off + 17];
+			int coarse = patch[off + 18];
+			int fine = patch[off + 19];
+			int detune = patch[off + 20];
+
+			prepared.mode[op] = mode;
+			prepared.ampmodsens[op] = AmpModSensitivity(patch[off + 14]);
+			prepared.velocity_sensitivity[op] = patch[off + 15];
+
+			int outlevel = Env::scaleoutlevel(patch[off + 16]);
+
+			for (int midinote = 0; midinote < 128; midinote++) {
+				int level_scaling = ScaleLevel(midinote, patch[off + 8], patch[off + 9],
+					patch[off + 10], patch[off + 11], patch[off + 12]);
+
+				prepared.outlevel[op][midinote] = std::min(127, outlevel + level_scaling) << 5;
+				prepared.rate_scaling[op][midinote] = ScaleRate(midinote, patch[off + 13]);
+				prepared.basepitch[op][midinote] = OscFreq(tuning, midinote, mode, coarse, fine, detune);
+			}
+		}
+
+		for (int i = 0; i < 4; i++) {
+			prepared.pitch_rates[i] = patch[126 + i];
+			prepared.pitch_levels[i] = patch[130 + i];
+		}
+
+		prepared.algorithm = patch[134];
+		prepared.fb_shift = FeedbackShift(patch[135]);
+		prepared.pitchmoddepth = (patch[139] * 165) >> 6;
+		prepared.pitchmodsens = PitchModSensitivity(patch[143]);
+		prepared.ampmoddepth = (patch[140] * 165) >> 6;
+	}
+
+
+	PatchCache::PatchCache(size_t capacity)
+		:m_capacity(std::max(capacity, size_t(1))),
+		m_tuning(createStandardTuning())
+	{
+	}
+
+	PreparedBankPtr PatchCache::get(int group, int bank, const uint8_t* bank_data) {
+		std::unique_lock<std::mutex> lock(m_mutex);
+		Key key(group, bank);
+
+		auto found = m_index.find(key);
+		if (found != m_index.end()) {
+			// move to the front, no allocation involved
+			m_entries.splice(m_entries.begin(), m_entries, found->second);
+			return found->second->second;
+		}
+
+		m_entries.emplace_front(key, build(group, bank, bank_data));
+		m_index[key] = m_entries.begin();
+
+		// evicted banks are freed here, or by whoever drops the last reference to them
+		while (m_entries.size() > m_capacity) {
+			m_index.erase(m_entries.back().first);
+			m_entries.pop_back();
+		}
+
+		return m_entries.front().second;
+	}
+
+	PreparedBankPtr PatchCache::prepare(const uint8_t* bank_data) {
+		std::unique_lock<std::mutex> lock(m_mutex);
+		return build(-1, -1, bank_data);
+	}
+
+	size_t PatchCache::size() const {
+		std::unique_lock<std::mutex> lock(m_mutex);
+		return m_entries.size();
+	}
+
+	PreparedBankPtr PatchCache::build(int group, int bank, const uint8_t* bank_data) {
+		auto prepared = std::make_shared<PreparedBank>();
+		prepared->group = group;
+		prepared->bank = bank;
+
+		for (int program = 0; program != 32; ++program) {
+			char unpacked[156];
+			UnpackPatch((const char*)bank_data + 128 * program, unpacked);
+
+			auto patch = std::make_shared<PreparedPatch>();
+			PreparePatch(unpacked, *m_tuning, *patch);
+			prepared->patches[program] = patch;
+		}
+
+		return prepared;
+	}
+}
\ No newline at end of file
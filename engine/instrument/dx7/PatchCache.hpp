@@ -0,0 +1,92 @@
+#pragma once
+
+#include "synth.h"
+#include "tuning.h"
+
+#include <array>
+#include <list>
+#include <map>
+#include <mutex>
+
+namespace dx7 {
+
+	//
+	// An unpacked voice plus everything Dx7Note::init needs that only depends on the patch and the key,
+	// so starting a note is a handful of table lookups.
+	//
+	struct PreparedPatch {
+		char unpacked[156];
+		char name[11];
+
+		int32_t basepitch[6][128];	// operator log frequency per midi note
+		int32_t outlevel[6][128];	// output level with keyboard level scaling applied (before velocity)
+		int32_t rate_scaling[6][128];	// envelope rate scaling per midi note
+
+		int rates[6][4];
+		int levels[6][4];
+		int velocity_sensitivity[6];
+		int32_t ampmodsens[6];
+		int32_t mode[6];
+
+		int pitch_rates[4];
+		int pitch_levels[4];
+
+		int algorithm;
+		int32_t fb_shift;
+		int pitchmoddepth;
+		int pitchmodsens;
+		int ampmoddepth;
+	};
+
+	using PreparedPatchPtr = std::shared_ptr<PreparedPatch const>;
+
+	// Derives a PreparedPatch from a 156 byte unpacked voice
+	void PreparePatch(const char unpacked[156], TuningState& tuning, PreparedPatch& prepared);
+
+
+	//
+	// The 32 prepared voices of a bank, program changes on the audio thread only pick one of them
+	//
+	struct PreparedBank {
+		int group;	// cache key, -1 for sysex banks
+		int bank;
+
+		std::array<PreparedPatchPtr, 32> patches;
+	};
+
+	using PreparedBankPtr = std::shared_ptr<PreparedBank const>;
+
+
+	//
+	// LRU cache of prepared banks keyed by group/bank, thread safe.
+	// It derives and allocates, so it is only used off the audio thread, which gets the finished banks
+	//
+	class PatchCache {
+	public:
+		explicit PatchCache(size_t capacity);
+
+		PatchCache(PatchCache const&) = delete;
+		PatchCache& operator=(PatchCache const&) = delete;
+
+		// returns the prepared bank, deriving its voices from the 4096 bytes of packed data on a miss
+		PreparedBankPtr get(int group, int bank, const uint8_t* bank_data);
+
+		// prepares a bank that is not cached (sysex dumps)
+		PreparedBankPtr prepare(const uint8_t* bank_data);
+
+		size_t size() const;
+	private:
+		using Key = std::pair<int, int>; // group, bank
+		using Entry = std::pair<Key, PreparedBankPtr>;
+
+		size_t m_capacity;
+		std::shared_ptr<TuningState> m_tuning;
+
+		mutable std::mutex m_mutex;
+		std::list<Entry> m_entries; // most recently used at the front
+		std::map<Key, std::list<Entry>::iterator> m_index;
+
+		PreparedBankPtr build(int group, int bank, const uint8_t* bank_data);
+	};
+
+}
\ No newline at end of file
@@ -19,6 +19,7 @@
 #include "exp2.h"
 #include "controllers.h"
 #include "dx7note.h"
+#include "PatchCache.hpp"
 
 namespace dx7 {
 
@@ -33,10 +34,14 @@ const int32_t coarsemul[] = {
 };
 
 int32_t Dx7Note::osc_freq(int midinote, int mode, int coarse, int fine, int detune) {
+    return OscFreq(*tuning_state_, midinote, mode, coarse, fine, detune);
+}
+
+int32_t OscFreq(TuningState &tuning, int midinote, int mode, int coarse, int fine, int detune) {
     // TODO: pitch randomization
     int32_t logfreq;
     if (mode == 0) {
-        logfreq = tuning_state_->midinote_to_logfreq(midinote);
+        logfreq = tuning.midinote_to_logfreq(midinote);
 
         // could use more precision, closer enough for now. those numbers comes from my DX7
         double detuneRatio = 0.0209 * exp(-0.396 * (((float)logfreq)/(1<<24))) / 7;
@@ -130,6 +135,18 @@ static const uint32_t ampmodsenstab[] = {
     0, 4342338, 7171437, 16777216
 };
 
+int32_t AmpModSensitivity(int sensitivity) {
+    return ampmodsenstab[sensitivity & 3];
+}
+
+int PitchModSensitivity(int sensitivity) {
+    return pitchmodsenstab[sensitivity & 7];
+}
+
+int32_t FeedbackShift(int feedback) {
+    return feedback != 0 ? FEEDBACK_BITDEPTH - feedback : 16;
+}
+
 Dx7Note::Dx7Note(std::shared_ptr<TuningState> ts) : tuning_state_(ts) {
     for(int op=0;op<6;op++) {
         params_[op].phase = 0;
@@ -186,6 +203,31 @@ void Dx7Note::init(const uint8_t patch[156], int midinote, int velocity) {
     mpePressure = 0;
 }
 
+void Dx7Note::init(const PreparedPatch &patch, int midinote, int velocity) {
+    playingMidiNote = midinote;
+    for (int op = 0; op < 6; op++) {
+        int outlevel = patch.outlevel[op][midinote];
+        outlevel += ScaleVelocity(velocity, patch.velocity_sensitivity[op]);
+        outlevel = std::max(0, outlevel);
+        env_[op].init(patch.rates[op], patch.levels[op], outlevel, patch.rate_scaling[op][midinote]);
+
+        opMode[op] = patch.mode[op];
+        basepitch_[op] = patch.basepitch[op][midinote];
+        ampmodsens_[op] = patch.ampmodsens[op];
+    }
+    pitchenv_.set(patch.pitch_rates, patch.pitch_levels);
+    algorithm_ = patch.algorithm;
+    fb_shift_ = patch.fb_shift;
+    pitchmoddepth_ = patch.pitchmoddepth;
+    pitchmodsens_ = patch.pitchmodsens;
+    ampmoddepth_ = patch.ampmoddepth;
+
+    // MPE default valeus
+    mpePitchBend = 8192;
+    mpeTimbre = 0;
+    mpePressure = 0;
+}
+
 void Dx7Note::compute(int32_t *buf, int32_t lfo_val, int32_t lfo_delay, const Controllers *ctrls) {
     // ==== PITCH ====
     uint32_t pmd = pitchmoddepth_ * lfo_delay;  // Q32
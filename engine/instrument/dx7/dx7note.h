@@ -29,6 +29,18 @@
 
 namespace dx7 {
 
+struct PreparedPatch;
+
+// Patch scaling helpers, shared with PreparePatch
+int32_t OscFreq(TuningState &tuning, int midinote, int mode, int coarse, int fine, int detune);
+int ScaleVelocity(int velocity, int sensitivity);
+int ScaleRate(int midinote, int sensitivity);
+int ScaleLevel(int midinote, int break_pt, int left_depth, int right_depth,
+               int left_curve, int right_curve);
+int32_t AmpModSensitivity(int sensitivity);
+int PitchModSensitivity(int sensitivity);
+int32_t FeedbackShift(int feedback);
+
 struct VoiceStatus {
     uint32_t amp[6];
     char ampStep[6];
@@ -40,6 +52,9 @@ public:
     Dx7Note(std::shared_ptr<TuningState> ts);
     void init(const uint8_t patch[156], int midinote, int velocity);
 
+    // Same as init but everything that only depends on the patch and key comes precomputed
+    void init(const PreparedPatch &patch, int midinote, int velocity);
+
     // Note: this _adds_ to the buffer. Interesting question whether it's
     // worth it...
     void compute(int32_t *buf, int32_t lfo_val, int32_t lfo_delay,
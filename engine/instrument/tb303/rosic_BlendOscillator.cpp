@@ -21,9 +21,6 @@ BlendOscillator::BlendOscillator()
   setFrequency (440.0);            // frequency = 440 Hz by default
   setStartPhase(0.0);              // sartPhase = 0 by default
 
-  setWaveForm1(MipMappedWaveTable::SAW);
-  setWaveForm2(MipMappedWaveTable::SQUARE);
-
   resetPhase();
 }
 
@@ -43,24 +40,12 @@ void BlendOscillator::setSampleRate(double newSampleRate)
   increment = tableLengthDbl*freq*sampleRateRec;
 }
 
-void BlendOscillator::setWaveForm1(int newWaveForm1)
-{
-  if( waveTable1 != NULL )
-    waveTable1->setWaveform(newWaveForm1);
-}
-
-void BlendOscillator::setWaveForm2(int newWaveForm2)
-{
-  if( waveTable2 != NULL )
-    waveTable2->setWaveform(newWaveForm2);
-}
-
-void BlendOscillator::setWaveTable1(MipMappedWaveTable* newWaveTable1)
+void BlendOscillator::setWaveTable1(const MipMappedWaveTable* newWaveTable1)
 {
   waveTable1 = newWaveTable1;
 }
 
-void BlendOscillator::setWaveTable2(MipMappedWaveTable* newWaveTable2)
+void BlendOscillator::setWaveTable2(const MipMappedWaveTable* newWaveTable2)
 {
   waveTable2 = newWaveTable2;
 }
@@ -35,23 +35,18 @@ namespace rosic
     /** Sets the sample-rateRate(). */
     void setSampleRate(double newSampleRate);
 
-    /** Sets the 1st waveform of the oscillator. */
-    void setWaveForm1(int newWaveForm1);
-
-    /** Sets the 2nd waveform of the oscillator. */
-    void setWaveForm2(int newWaveForm2);
-
     /** Set start phase (range 0 - 360 degrees). */
     void setStartPhase(double StartPhase);
 
     /** An object of class WaveTable should be passed with this function which will be used in the 
     oscillator. Not to have "our own" WaveTable-object as member-variable avoids the need to have 
-    the same waveform for different synth-voices multiple times in the memory. This function sets 
-    the 1st wavetable. */
-    void setWaveTable1(MipMappedWaveTable* newWaveTable1);
+    the same waveform for different synth-voices multiple times in the memory. The tables are only 
+    read (they may be shared, see MipMappedWaveTable::getShared), so the waveform and pulse width 
+    are chosen by passing the respective table. This function sets the 1st wavetable. */
+    void setWaveTable1(const MipMappedWaveTable* newWaveTable1);
 
     /** Sets the 2nd wavetable. @see setWaveTable1 */
-    void setWaveTable2(MipMappedWaveTable* newWaveTable2);
+    void setWaveTable2(const MipMappedWaveTable* newWaveTable2);
 
     /** Sets the blend/mix factor between the two waveforms. The value is expected between 0...1
     where 0 means waveform1 only, 1 means waveform2 only - in between there will be a linear blend
@@ -61,9 +56,6 @@ namespace rosic
     /** Sets the frequency of the oscillator. */
     INLINE void setFrequency(double newFrequency);
 
-    /** Sets the pulse width (or symmetry) of the oscillator. */
-    INLINE void setPulseWidth(double newPulseWidth);
-
     /** Sets the phase increment from outside. */
     INLINE void setIncrement(double newIncrement) { increment = newIncrement; }
 
@@ -78,6 +70,12 @@ namespace rosic
     /** Returns the phase increment. */
     INLINE double getIncrement() const { return increment; }
 
+    /** Returns the 1st wavetable. */
+    const MipMappedWaveTable* getWaveTable1() const { return waveTable1; }
+
+    /** Returns the 2nd wavetable. */
+    const MipMappedWaveTable* getWaveTable2() const { return waveTable2; }
+
     //---------------------------------------------------------------------------------------------
     // audio processing:
 
@@ -110,7 +108,7 @@ namespace rosic
     double sampleRate;        // the samplerate
     double sampleRateRec;     // 1/sampleRate
 
-    MipMappedWaveTable *waveTable1, *waveTable2; // the 2 wavetables between which we blend
+    const MipMappedWaveTable *waveTable1, *waveTable2; // the 2 wavetables between which we blend
 
   };
 
@@ -123,12 +121,6 @@ namespace rosic
       freq = newFrequency;
   }
 
-  INLINE void BlendOscillator::setPulseWidth(double newPulseWidth)
-  {
-    waveTable1->setSymmetry(0.01*newPulseWidth);
-    waveTable2->setSymmetry(0.01*newPulseWidth);
-  }
-
   INLINE void BlendOscillator::calculateIncrement()
   {
     increment = tableLengthDbl*freq*sampleRateRec;
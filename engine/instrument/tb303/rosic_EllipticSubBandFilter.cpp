@@ -0,0 +1,28 @@
+#include "rosic_EllipticSubBandFilter.h"
+using namespace rosic;
+
+//-------------------------------------------------------------------------------------------------
+// coefficients:
+
+const double rosic::ellipticSubBandSections[2][6][5] =
+{
+  // half band, ellip(12, 0.1, 96, 0.45):
+  {
+    { 0.0020774401626399053, 0.0038735228821777461, 0.0020774401626399049, -1.1285692959893585, 0.36218012573257785 },
+    { 1.0,  1.1454473468979027,   1.0, -0.9052969110519562,  0.51487929297667301 },
+    { 1.0,  0.52735539422369515,  1.0, -0.64065016867181501, 0.69747080263947403 },
+    { 1.0,  0.18283233173994293,  1.0, -0.44882831659514599, 0.83398741685865263 },
+    { 1.0,  0.015301372598186012, 1.0, -0.34062884825373169, 0.92029637412679433 },
+    { 1.0, -0.051826006791019334, 1.0, -0.29617798694631359, 0.97642843304048299 }
+  },
+
+  // quarter band, same response as EllipticQuarterBandFilter:
+  {
+    { 0.00013671732099945628, 0.00018695892579344398, 0.00013671732099945625, -1.5863116558967594, 0.64282028140329639 },
+    { 1.0, -0.37140354711055229, 1.0, -1.5620957226108478, 0.716157087841919   },
+    { 1.0, -1.0298242815703607,  1.0, -1.5310700889597255, 0.81309516633377865 },
+    { 1.0, -1.2676403937323579,  1.0, -1.5080939976299184, 0.89315821803326445 },
+    { 1.0, -1.3628794779199336,  1.0, -1.4983265470405234, 0.94752881661124588 },
+    { 1.0, -1.398024716378069,   1.0, -1.5032624530811747, 0.98437474069429132 }
+  }
+};
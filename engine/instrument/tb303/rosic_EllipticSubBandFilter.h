@@ -0,0 +1,101 @@
+#ifndef rosic_EllipticSubBandFilter_h
+#define rosic_EllipticSubBandFilter_h
+
+// rosic-indcludes:
+#include "GlobalDefinitions.h"
+
+namespace rosic
+{
+
+  /** Second order sections (b0, b1, b2, a1, a2) of the half band [0] and quarter band [1] 
+  decimation filters. */
+  extern const double ellipticSubBandSections[2][6][5];
+
+  /**
+
+  This is an elliptic subband filter of 12th order for decimating a signal that was oversampled by 
+  a factor of 2 or 4. It is implemented as a cascade of 6 biquads in transposed direct form II, so 
+  it also behaves well in single precision (the 12th order direct form of 
+  EllipticQuarterBandFilter does not).
+
+  The quarter band version is the design of EllipticQuarterBandFilter (0.1 dB ripple, 96 dB 
+  stopband attenuation), the half band version has the same ripple and attenuation with the 
+  passband ending at 0.45 times the Nyquist frequency.
+
+  */
+
+  template<class T>
+  class EllipticSubBandFilter
+  {
+
+  public:
+
+    //---------------------------------------------------------------------------------------------
+    // construction/destruction:
+
+    /** Constructor. */
+    EllipticSubBandFilter() { setOversampling(4); }
+
+    //---------------------------------------------------------------------------------------------
+    // parameter settings:
+
+    /** Selects the filter for the given oversampling factor (2 or 4) - with a factor of 1, the 
+    filter just passes the signal through. */
+    void setOversampling(int newOversampling)
+    {
+      bypass = (newOversampling != 2 && newOversampling != 4);
+
+      const double (*sections)[5] = ellipticSubBandSections[newOversampling == 2 ? 0 : 1];
+      for(int s=0; s<numStages; s++)
+      {
+        b0[s] = (T) sections[s][0];
+        b1[s] = (T) sections[s][1];
+        b2[s] = (T) sections[s][2];
+        a1[s] = (T) sections[s][3];
+        a2[s] = (T) sections[s][4];
+      }
+      reset();
+    }
+
+    /** Resets the filter state. */
+    void reset()
+    {
+      for(int s=0; s<numStages; s++)
+        z1[s] = z2[s] = 0;
+    }
+
+    //---------------------------------------------------------------------------------------------
+    // audio processing:
+
+    /** Calculates a single filtered output-sample. */
+    INLINE T getSample(T in)
+    {
+      if( bypass )
+        return in;
+
+      T x = in + (T) TINY;
+      for(int s=0; s<numStages; s++)
+      {
+        T y   = b0[s]*x + z1[s];
+        z1[s] = b1[s]*x - a1[s]*y + z2[s];
+        z2[s] = b2[s]*x - a2[s]*y;
+        x     = y;
+      }
+      return x;
+    }
+
+    //=============================================================================================
+
+  protected:
+
+    static const int numStages = 6;
+
+    bool bypass;
+    T b0[numStages], b1[numStages], b2[numStages], a1[numStages], a2[numStages];
+    T z1[numStages], z2[numStages];
+
+  };
+
+} // end namespace rosic
+
+#endif // rosic_EllipticSubBandFilter_h
@@ -0,0 +1,95 @@
+#ifndef rosic_MidiNoteStack_h
+#define rosic_MidiNoteStack_h
+
+// rosic-indcludes:
+#include "GlobalDefinitions.h"
+#include "rosic_MidiNoteEvent.h"
+
+namespace rosic
+{
+
+  /**
+
+  This is a fixed capacity stack of held MIDI notes with last-note priority: the most recently 
+  pushed note is on top and removing a key removes every entry of that key, exactly like the 
+  std::list based note list it replaces, but without touching the allocator when notes come and 
+  go. When more notes are held than the capacity allows, the oldest one is forgotten.
+
+  */
+
+  class MidiNoteStack
+  {
+
+  public:
+
+    /** Maximum number of held notes (one per MIDI key). */
+    static const int capacity = 128;
+
+    //---------------------------------------------------------------------------------------------
+    // construction/destruction:
+
+    /** Constructor. */
+    MidiNoteStack() : numNotes(0) {}
+
+    //---------------------------------------------------------------------------------------------
+    // inquiry:
+
+    /** True, when no note is held. */
+    bool empty() const { return numNotes == 0; }
+
+    /** Returns the number of held notes. */
+    int size() const { return numNotes; }
+
+    /** Returns the most recent note that is still held - the stack must not be empty. */
+    const MidiNoteEvent& front() const { return notes[numNotes-1]; }
+
+    //---------------------------------------------------------------------------------------------
+    // manipulation:
+
+    /** Pushes a new note on top of the stack. */
+    INLINE void push_front(const MidiNoteEvent& newNote);
+
+    /** Removes all the notes that are equal to the passed one (that is: have the same key). */
+    INLINE void remove(const MidiNoteEvent& noteToRemove);
+
+    /** Forgets all the held notes. */
+    void clear() { numNotes = 0; }
+
+    //=============================================================================================
+
+  protected:
+
+    MidiNoteEvent notes[capacity]; // oldest note first, most recent note last
+    int           numNotes;
+
+  };
+
+  //-----------------------------------------------------------------------------------------------
+  // inlined functions:
+
+  INLINE void MidiNoteStack::push_front(const MidiNoteEvent& newNote)
+  {
+    if( numNotes == capacity )
+    {
+      // drop the oldest note:
+      for(int i=1; i<numNotes; i++)
+        notes[i-1] = notes[i];
+      numNotes--;
+    }
+    notes[numNotes++] = newNote;
+  }
+
+  INLINE void MidiNoteStack::remove(const MidiNoteEvent& noteToRemove)
+  {
+    int kept = 0;
+    for(int i=0; i<numNotes; i++)
+    {
+      if( !(notes[i] == noteToRemove) )
+        notes[kept++] = notes[i];
+    }
+    numNotes = kept;
+  }
+
+} // end namespace rosic
+
+#endif // rosic_MidiNoteStack_h
@@ -1,4 +1,9 @@
 #include "rosic_MipMappedWaveTable.h"
+
+#include <map>
+#include <mutex>
+#include <tuple>
+
 using namespace rosic;
 
 MipMappedWaveTable::MipMappedWaveTable()
@@ -21,11 +26,59 @@ MipMappedWaveTable::MipMappedWaveTable()
   initTableSet();
 }
 
+MipMappedWaveTable::MipMappedWaveTable(int waveform, double symmetry, double tanhShaperDrive, 
+  double tanhShaperOffset, double squarePhaseShift)
+{
+  sampleRate             = 44100.0;
+  this->waveform         = waveform;
+  this->symmetry         = symmetry;
+  this->tanhShaperFactor = dB2amp(tanhShaperDrive);
+  this->tanhShaperOffset = tanhShaperOffset;
+  this->squarePhaseShift = squarePhaseShift;
+
+  fourierTransformer.setBlockSize(tableLength);
+
+  // the fillWith...() functions write the whole prototype table and every table of the mip-map, 
+  // so nothing is cleared first:
+  renderWaveform();
+}
+
 MipMappedWaveTable::~MipMappedWaveTable()
 {
 
 }
 
+std::shared_ptr<const MipMappedWaveTable> MipMappedWaveTable::getShared(int waveform, 
+  double symmetry, double tanhShaperDrive, double tanhShaperOffset, double squarePhaseShift)
+{
+  typedef std::tuple<int, double, double, double, double> Key;
+
+  static std::mutex mutex;
+  static std::map<Key, std::weak_ptr<const MipMappedWaveTable> > tables;
+
+  // generateMipMap works on static buffers, so rendering under the lock also keeps it safe:
+  std::lock_guard<std::mutex> lock(mutex);
+
+  Key key(waveform, symmetry, tanhShaperDrive, tanhShaperOffset, squarePhaseShift);
+  auto found = tables.find(key);
+  if( found != tables.end() )
+  {
+    std::shared_ptr<const MipMappedWaveTable> table = found->second.lock();
+    if( table )
+      return table;
+  }
+
+  // forget the tables nobody holds anymore (tweaking the 303 square leaves one per setting):
+  for(auto i = tables.begin(); i != tables.end(); )
+    i = i->second.expired() ? tables.erase(i) : std::next(i);
+
+  std::shared_ptr<const MipMappedWaveTable> rendered = std::make_shared<const MipMappedWaveTable>(
+    waveform, symmetry, tanhShaperDrive, tanhShaperOffset, squarePhaseShift);
+
+  tables[key] = rendered;
+  return rendered;
+}
+
 //-------------------------------------------------------------------------------------------------
 // parameter settings:
 
@@ -66,7 +119,8 @@ void MipMappedWaveTable::setSymmetry(double newSymmetry)
 
 void MipMappedWaveTable::initPrototypeTable()
 {
-  for(int i=0; i<(tableLength+4); i++)
+  // the prototype has no additional interpolation samples (only the tables of the mip-map have):
+  for(int i=0; i<tableLength; i++)
     prototypeTable[i] = 0.0;
 }
 
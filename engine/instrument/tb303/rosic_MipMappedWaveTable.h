@@ -5,6 +5,8 @@
 #include "rosic_FunctionTemplates.h"
 #include "rosic_FourierTransformerRadix2.h"
 
+#include <memory>
+
 namespace rosic
 {
 
@@ -23,6 +25,7 @@ namespace rosic
     friend class Oscillator;
     friend class BlendOscillator;
     friend class SuperOscillator;
+    friend class SinglePrecisionCore;
     // \ todo: get rid of this by providing get-functions
 
   public:
@@ -44,9 +47,19 @@ namespace rosic
     /** Constructor. */
     MipMappedWaveTable();          
 
+    /** Constructor. Renders the given waveform and settings once, as getShared needs them. */
+    MipMappedWaveTable(int waveform, double symmetry, double tanhShaperDrive, 
+      double tanhShaperOffset, double squarePhaseShift);
+
     /** Destructor. */
     ~MipMappedWaveTable();         
 
+    /** Returns a table with the given waveform and settings that is shared by the whole process. 
+    Each distinct table is rendered once, on its first request, and stays alive as long as someone 
+    holds it. The returned table must not be modified. */
+    static std::shared_ptr<const MipMappedWaveTable> getShared(int waveform, double symmetry = 0.5, 
+      double tanhShaperDrive = 36.9, double tanhShaperOffset = 4.37, double squarePhaseShift = 180.0);
+
     //---------------------------------------------------------------------------------------------
     // parmeter-settings:
 
@@ -107,12 +120,12 @@ namespace rosic
     linear interpolation - this function may be preferred over 
     getValueLinear(double phaseIndex, int tableIndex) when you want to calculate the integer and 
     fractional part of the phase-index yourself. */
-    INLINE double getValueLinear(int integerPart, double fractionalPart, int tableIndex);
+    INLINE double getValueLinear(int integerPart, double fractionalPart, int tableIndex) const;
 
     /** Returns the value at position 'phaseIndex' of table 'tableIndex' with linear 
     interpolation - this function computes the integer and fractional part of the phaseIndex
     internally. */
-    INLINE double getValueLinear(double phaseIndex, int tableIndex);
+    INLINE double getValueLinear(double phaseIndex, int tableIndex) const;
 
   protected:
 
@@ -191,7 +204,7 @@ namespace rosic
   //-----------------------------------------------------------------------------------------------
   // inlined functions:
     
-  INLINE double MipMappedWaveTable::getValueLinear(int integerPart, double fractionalPart, int tableIndex)
+  INLINE double MipMappedWaveTable::getValueLinear(int integerPart, double fractionalPart, int tableIndex) const
   {
     // ensure, that the table index is in the valid range:
     if( tableIndex<=0 )
@@ -203,7 +216,7 @@ namespace rosic
            +      fractionalPart  * tableSet[tableIndex][integerPart+1];
   }
 
-  INLINE double MipMappedWaveTable::getValueLinear(double phaseIndex, int tableIndex)
+  INLINE double MipMappedWaveTable::getValueLinear(double phaseIndex, int tableIndex) const
   {
     /*
     // ensure, that the table index is in the valid range:
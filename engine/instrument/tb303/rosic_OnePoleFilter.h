@@ -72,6 +72,15 @@ namespace rosic
     /** Returns the cutoff-frequency. */
     double getCutoff() const { return cutoff; }
 
+    /** Returns the feedforward coefficient for the current input sample. */
+    double getB0() const { return b0; }
+
+    /** Returns the feedforward coefficient for the previous input sample. */
+    double getB1() const { return b1; }
+
+    /** Returns the feedback coefficient. */
+    double getA1() const { return a1; }
+
     //---------------------------------------------------------------------------------------------
     // audio processing:
 
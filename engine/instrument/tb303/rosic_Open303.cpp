@@ -29,13 +29,15 @@ Open303::Open303()
   noteOffCountDown =     0;
   slideToNextNote  = false;
   idle             = true;
+  oversampling     = 4;
+  singlePrecision  = false;
 
   setEnvMod(25.0);
 
-  oscillator.setWaveTable1(&waveTable1);
-  oscillator.setWaveForm1(MipMappedWaveTable::SAW303);
-  oscillator.setWaveTable2(&waveTable2);
-  oscillator.setWaveForm2(MipMappedWaveTable::SQUARE303);
+  waveTable1 = MipMappedWaveTable::getShared(MipMappedWaveTable::SAW303);
+  waveTable2 = MipMappedWaveTable::getShared(MipMappedWaveTable::SQUARE303);
+  oscillator.setWaveTable1(waveTable1.get());
+  oscillator.setWaveTable2(waveTable2.get());
 
   //mainEnv.setNormalizeSum(true);
   mainEnv.setNormalizeSum(false);
@@ -63,7 +65,6 @@ Open303::Open303()
   setSampleRate(sampleRate);
 
   // tweakables:
-  oscillator.setPulseWidth(50.0);
   highpass1.setCutoff(44.486);
   highpass2.setCutoff(24.167);
   allpass.setCutoff(14.008);
@@ -83,6 +84,8 @@ Open303::~Open303()
 
 void Open303::setSampleRate(double newSampleRate)
 {
+  sampleRate = newSampleRate;
+
   mainEnv.setSampleRate         (       newSampleRate);
   ampEnv.setSampleRate          (       newSampleRate);
   pitchSlewLimiter.setSampleRate((float)newSampleRate);
@@ -138,6 +141,27 @@ void Open303::setPitchBend(double newPitchBend)
   pitchWheelFactor = pitchOffsetToFreqFactor(newPitchBend);
 }
 
+void Open303::setOversampling(int newOversampling)
+{
+  if( newOversampling != 1 && newOversampling != 2 && newOversampling != 4 )
+    return;
+
+  oversampling = newOversampling;
+  decimator.setOversampling(oversampling);
+  singlePrecisionCore.setOversampling(oversampling);
+  setSampleRate(sampleRate);
+  resetOversampledState();
+}
+
+void Open303::setSinglePrecision(bool shouldUseSinglePrecision)
+{
+  if( singlePrecision == shouldUseSinglePrecision )
+    return;
+
+  singlePrecision = shouldUseSinglePrecision;
+  resetOversampledState();
+}
+
 //------------------------------------------------------------------------------------------------------------
 // others:
 
@@ -216,6 +240,8 @@ void Open303::triggerNote(int noteNumber, bool hasAccent)
     allpass.reset();
     notch.reset();
     antiAliasFilter.reset();
+    decimator.reset();
+    singlePrecisionCore.reset();
     ampDeClicker.reset();
   }
 
@@ -274,6 +300,23 @@ void Open303::releaseNote(int noteNumber)
   }
 }
 
+void Open303::setSquareTable(double drive, double offset, double phaseShift)
+{
+  waveTable2 = MipMappedWaveTable::getShared(MipMappedWaveTable::SQUARE303, 0.5, drive, offset, 
+    phaseShift);
+  oscillator.setWaveTable2(waveTable2.get());
+}
+
+void Open303::resetOversampledState()
+{
+  oscillator.resetPhase();
+  filter.reset();
+  highpass1.reset();
+  antiAliasFilter.reset();
+  decimator.reset();
+  singlePrecisionCore.reset();
+}
+
 void Open303::setMainEnvDecay(double newDecay)
 {
   mainEnv.setDecayTimeConstant(newDecay);
@@ -1,7 +1,7 @@
 #ifndef rosic_Open303_h
 #define rosic_Open303_h
 
-#include "rosic_MidiNoteEvent.h"
+#include "rosic_MidiNoteStack.h"
 #include "rosic_BlendOscillator.h"
 #include "rosic_BiquadFilter.h"
 #include "rosic_TeeBeeFilter.h"
@@ -9,9 +9,10 @@
 #include "rosic_DecayEnvelope.h"
 #include "rosic_LeakyIntegrator.h"
 #include "rosic_EllipticQuarterBandFilter.h"
+#include "rosic_EllipticSubBandFilter.h"
+#include "rosic_SinglePrecisionCore.h"
 #include "rosic_AcidSequencer.h"
 
-#include <list>
 #include <limits>
 
 namespace rosic
@@ -80,11 +81,13 @@ namespace rosic
 
     /** Sets the drive (in dB) for the tanh-shaper for 303-square waveform - internal parameter, to 
     be scrapped eventually. */
-    void setTanhShaperDrive(double newDrive) { waveTable2.setTanhShaperDriveFor303Square(newDrive); }
+    void setTanhShaperDrive(double newDrive) 
+    { setSquareTable(newDrive, getTanhShaperOffset(), getSquarePhaseShift()); }
 
     /** Sets the offset (as raw value for the tanh-shaper for 303-square waveform - internal 
     parameter, to be scrapped eventually. */
-    void setTanhShaperOffset(double newOffset) { waveTable2.setTanhShaperOffsetFor303Square(newOffset); }
+    void setTanhShaperOffset(double newOffset) 
+    { setSquareTable(getTanhShaperDrive(), newOffset, getSquarePhaseShift()); }
 
     /** Sets the cutoff frequency for the highpass before the main filter. */
     void setPreFilterHighpass(double newCutoff) { highpass1.setCutoff(newCutoff); }
@@ -97,7 +100,8 @@ namespace rosic
 
     /** Sets the phase shift of tanh-shaped square wave with respect to the saw-wave (in degrees)
     - this is important when the two are mixed. */
-    void setSquarePhaseShift(double newShift) { waveTable2.set303SquarePhaseShift(newShift); }
+    void setSquarePhaseShift(double newShift) 
+    { setSquareTable(getTanhShaperDrive(), getTanhShaperOffset(), newShift); }
 
     /** Sets the slide-time (in ms). The TB-303 had a slide time of 60 ms. */
     void setSlideTime(double newSlideTime);
@@ -172,11 +176,11 @@ namespace rosic
 
     /** Returns the drive (in dB) for the tanh-shaper for 303-square waveform - internal parameter, 
     to be scrapped eventually. */
-    double getTanhShaperDrive() const { return waveTable2.getTanhShaperDriveFor303Square(); }
+    double getTanhShaperDrive() const { return waveTable2->getTanhShaperDriveFor303Square(); }
 
     /** Returns the offset (as raw value for the tanh-shaper for 303-square waveform - internal 
     parameter, to be scrapped eventually. */   
-    double getTanhShaperOffset() const { return waveTable2.getTanhShaperOffsetFor303Square(); }
+    double getTanhShaperOffset() const { return waveTable2->getTanhShaperOffsetFor303Square(); }
 
     /** Returns the cutoff frequency for the highpass before the main filter. */
     double getPreFilterHighpass() const { return highpass1.getCutoff(); }
@@ -190,7 +194,7 @@ namespace rosic
 
     /** Returns the phase shift of tanh-shaped square wave with respect to the saw-wave (in degrees)
     - this is important when the two are mixed. */
-    double getSquarePhaseShift() const { return waveTable2.get303SquarePhaseShift(); }
+    double getSquarePhaseShift() const { return waveTable2->get303SquarePhaseShift(); }
 
     /** Returns the slide-time (in ms). */
     double getSlideTime() const { return slideTime; }
@@ -216,6 +220,9 @@ namespace rosic
     /** Calculates onse output sample at a time. */
     double getSample(); 
 
+    /** True when getSample has nothing to do (and returns 0) until the next note. */
+    bool isIdle() const { return idle; }
+
     //-----------------------------------------------------------------------------------------------
     // event handling:
 
@@ -228,10 +235,22 @@ namespace rosic
     /** Sets the pitchbend value in semitones. */ 
     void setPitchBend(double newPitchBend);  
 
+    /** Sets the oversampling factor for the oscillator and filter (1, 2 or 4). */ 
+    void setOversampling(int newOversampling);
+
+    /** Switches the oversampled part between single and double precision. */ 
+    void setSinglePrecision(bool shouldUseSinglePrecision);
+
+    /** Returns the oversampling factor for the oscillator and filter. */ 
+    int getOversampling() const { return oversampling; }
+
+    /** Returns true when the oversampled part runs in single precision. */ 
+    bool isSinglePrecision() const { return singlePrecision; }
+
     //-----------------------------------------------------------------------------------------------
     // embedded objects: 
 
-    MipMappedWaveTable        waveTable1, waveTable2;
+    std::shared_ptr<const MipMappedWaveTable> waveTable1, waveTable2; // shared by all instances
     BlendOscillator           oscillator;
     TeeBeeFilter              filter;
     AnalogEnvelope            ampEnv; 
@@ -243,6 +262,8 @@ namespace rosic
     OnePoleFilter             highpass1, highpass2, allpass; 
     BiquadFilter              notch;
     EllipticQuarterBandFilter antiAliasFilter;
+    EllipticSubBandFilter<double> decimator; // anti-aliasing for oversampling factors other than 4
+    SinglePrecisionCore       singlePrecisionCore;
     AcidSequencer             sequencer;
 
   protected:
@@ -272,7 +293,14 @@ namespace rosic
     main envelope generator. */
     void updateNormalizer2();
 
-    static const int oversampling = 4;
+    /** Picks the shared 303-square table for the given tanh-shaper settings. */
+    void setSquareTable(double drive, double offset, double phaseShift);
+
+    /** Resets the state of the oversampled part (used when its configuration changes). */
+    void resetOversampledState();
+
+    int    oversampling;     // oversampling factor for the oscillator and filter
+    bool   singlePrecision;  // run the oversampled part in float
 
     double tuning;           // master tunung for A4 in Hz
     double ampScaler;        // final volume as raw factor
@@ -301,7 +329,7 @@ namespace rosic
     bool   slideToNextNote;  // indicate that we need to slide to the next note in sequencer mode
     bool   idle;             // flag to indicate that we have currently nothing to do in getSample
 
-    std::list<MidiNoteEvent> noteList;
+    MidiNoteStack noteList;
 
   };
 
@@ -375,14 +403,30 @@ namespace rosic
     ampEnvOut = ampDeClicker.getSample(ampEnvOut);
 
     // oversampled calculations:
-    double tmp;
-    for(int i=1; i<=oversampling; i++)
+    double tmp = 0.0;
+    if( singlePrecision )
     {
-      tmp  = -oscillator.getSample();         // the raw oscillator signal 
-      tmp  = highpass1.getSample(tmp);        // pre-filter highpass
-      tmp  = filter.getSample(tmp);           // now it's filtered
-      tmp  = antiAliasFilter.getSample(tmp);  // anti-aliasing filtered
-
+      tmp = singlePrecisionCore.getSample(oscillator, highpass1, filter);
+    }
+    else if( oversampling == 4 )
+    {
+      for(int i=1; i<=oversampling; i++)
+      {
+        tmp  = -oscillator.getSample();         // the raw oscillator signal 
+        tmp  = highpass1.getSample(tmp);        // pre-filter highpass
+        tmp  = filter.getSample(tmp);           // now it's filtered
+        tmp  = antiAliasFilter.getSample(tmp);  // anti-aliasing filtered
+      }
+    }
+    else
+    {
+      for(int i=1; i<=oversampling; i++)
+      {
+        tmp  = -oscillator.getSample();  
+        tmp  = highpass1.getSample(tmp); 
+        tmp  = filter.getSample(tmp);    
+        tmp  = decimator.getSample(tmp);   
+      }
     }
 
     // these filters may actually operate without oversampling (but only if we reset them in
@@ -0,0 +1,37 @@
+#include "rosic_SinglePrecisionCore.h"
+using namespace rosic;
+
+//-------------------------------------------------------------------------------------------------
+// construction/destruction:
+
+SinglePrecisionCore::SinglePrecisionCore()
+{
+  setOversampling(4);
+}
+
+//-------------------------------------------------------------------------------------------------
+// parameter settings:
+
+void SinglePrecisionCore::setOversampling(int newOversampling)
+{
+  oversampling = newOversampling;
+  decimator.setOversampling(newOversampling);
+  reset();
+}
+
+//-------------------------------------------------------------------------------------------------
+// others:
+
+void SinglePrecisionCore::reset()
+{
+  phaseIndex = 0.0f;
+  preX1      = 0.0f;
+  preY1      = 0.0f;
+  feedbackX1 = 0.0f;
+  feedbackY1 = 0.0f;
+  y1         = 0.0f;
+  y2         = 0.0f;
+  y3         = 0.0f;
+  y4         = 0.0f;
+  decimator.reset();
+}
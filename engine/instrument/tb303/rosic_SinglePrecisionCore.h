@@ -0,0 +1,150 @@
+#ifndef rosic_SinglePrecisionCore_h
+#define rosic_SinglePrecisionCore_h
+
+// rosic-indcludes:
+#include "rosic_BlendOscillator.h"
+#include "rosic_TeeBeeFilter.h"
+#include "rosic_EllipticSubBandFilter.h"
+
+namespace rosic
+{
+
+  /**
+
+  This is the oversampled part of Open303 (oscillator, pre-filter highpass, TeeBeeFilter in TB_303 
+  mode and the decimation filter) computed in single precision. 
+
+  The coefficients are still calculated in double precision by the regular objects once per output 
+  sample and just read from them here - only the per sample recursions run in float, which is 
+  where the time goes when oversampling.
+
+  */
+
+  class SinglePrecisionCore
+  {
+
+  public:
+
+    //---------------------------------------------------------------------------------------------
+    // construction/destruction:
+
+    /** Constructor. */
+    SinglePrecisionCore();
+
+    //---------------------------------------------------------------------------------------------
+    // parameter settings:
+
+    /** Sets the oversampling factor (1, 2 or 4). */
+    void setOversampling(int newOversampling);
+
+    //---------------------------------------------------------------------------------------------
+    // audio processing:
+
+    /** Calculates one (decimated) output sample from the oscillator settings and the filters 
+    coefficients. */
+    INLINE float getSample(const BlendOscillator& oscillator, const OnePoleFilter& preFilter, 
+      const TeeBeeFilter& filter);
+
+    //---------------------------------------------------------------------------------------------
+    // others:
+
+    /** Resets the oscillator phase and the filter states. */
+    void reset();
+
+    //=============================================================================================
+
+  protected:
+
+    /** The nonlinearity of TeeBeeFilter::shape. */
+    INLINE static float shape(float x);
+
+    int   oversampling;
+    float phaseIndex;             // oscillator phase
+    float preX1, preY1;           // state of the pre-filter highpass
+    float feedbackX1, feedbackY1; // state of the highpass in the feedback path
+    float y1, y2, y3, y4;         // output signals of the 4 filter stages
+
+    EllipticSubBandFilter<float> decimator;
+
+  };
+
+  //-----------------------------------------------------------------------------------------------
+  // inlined functions:
+
+  INLINE float SinglePrecisionCore::shape(float x)
+  {
+    const float r6 = 1.0f/6.0f;
+    x = clip(x, (float) -SQRT2, (float) SQRT2);
+    return x - r6*x*x*x;
+  }
+
+  INLINE float SinglePrecisionCore::getSample(const BlendOscillator& oscillator, 
+    const OnePoleFilter& preFilter, const TeeBeeFilter& filter)
+  {
+    const MipMappedWaveTable* waveTable1 = oscillator.getWaveTable1();
+    const MipMappedWaveTable* waveTable2 = oscillator.getWaveTable2();
+    if( waveTable1 == NULL || waveTable2 == NULL )
+      return 0.0f;
+
+    // same table selection as BlendOscillator::getSample:
+    double increment   = oscillator.getIncrement();
+    int    tableNumber = clip((int)EXPOFDBL(increment) + 2, 0, MipMappedWaveTable::numTables-1);
+
+    const double* table1      = waveTable1->tableSet[tableNumber];
+    const double* table2      = waveTable2->tableSet[tableNumber];
+    const float   tableLength = (float) MipMappedWaveTable::tableLength;
+    const float   inc         = (float) increment;
+    const float   blend1      = (float) (1.0-oscillator.getBlendFactor());
+    const float   blend2      = (float) (0.5*oscillator.getBlendFactor());
+
+    const float preB0 = (float) preFilter.getB0();
+    const float preB1 = (float) preFilter.getB1();
+    const float preA1 = (float) preFilter.getA1();
+
+    const OnePoleFilter& feedbackHighpass = filter.getFeedbackHighpass();
+    const float fbB0 = (float) feedbackHighpass.getB0();
+    const float fbB1 = (float) feedbackHighpass.getB1();
+    const float fbA1 = (float) feedbackHighpass.getA1();
+
+    const float b0 = (float) filter.getB0();
+    const float k  = (float) filter.getFeedbackFactor();
+    const float g2 = (float) (2.0*filter.getOutputGain());
+
+    float out = 0.0f;
+    for(int i=1; i<=oversampling; i++)
+    {
+      // oscillator:
+      while( phaseIndex >= tableLength )
+        phaseIndex -= tableLength;
+      int   intIndex = (int) phaseIndex;
+      float frac     = phaseIndex - (float) intIndex;
+      float s1       = (float) table1[intIndex] + frac * (float) (table1[intIndex+1]-table1[intIndex]);
+      float s2       = (float) table2[intIndex] + frac * (float) (table2[intIndex+1]-table2[intIndex]);
+      float tmp      = -(blend1*s1 + blend2*s2);
+      phaseIndex    += inc;
+
+      // pre-filter highpass:
+      preY1 = preB0*tmp + preB1*preX1 + preA1*preY1 + (float) TINY;
+      preX1 = tmp;
+
+      // the filter:
+      float fb   = k * shape(y4);
+      feedbackY1 = fbB0*fb + fbB1*feedbackX1 + fbA1*feedbackY1 + (float) TINY;
+      feedbackX1 = fb;
+
+      float y0 = preY1 - feedbackY1;
+      y1 += 2*b0*(y0-y1+y2);
+      y2 +=   b0*(y1-2*y2+y3);
+      y3 +=   b0*(y2-2*y3+y4);
+      y4 +=   b0*(y3-2*y4);
+
+      // anti-aliasing:
+      out = decimator.getSample(g2*y4);
+    }
+
+    return out;
+  }
+
+} // end namespace rosic
+
+#endif // rosic_SinglePrecisionCore_h
@@ -100,6 +100,18 @@ namespace rosic
     /** Returns the cutoff frequency for the highpass filter in the feedback path. */
     double getFeedbackHighpassCutoff() const { return feedbackHighpass.getCutoff(); }
 
+    /** Returns the coefficient of the 4 filter stages. */
+    double getB0() const { return b0; }
+
+    /** Returns the feedback factor in the loop. */
+    double getFeedbackFactor() const { return k; }
+
+    /** Returns the output gain. */
+    double getOutputGain() const { return g; }
+
+    /** Returns the highpass filter in the feedback path. */
+    const OnePoleFilter& getFeedbackHighpass() const { return feedbackHighpass; }
+
     //---------------------------------------------------------------------------------------------
     // audio processing:
 
@@ -174,6 +174,7 @@ void restartAudioBackend() {
 	audio_des.stream_cb = audio_callback;
 	audio_des.buffer_frames = app.configuration().audio_buffer_size;
 	
+	app.engine().resetMidiLatency();
 	saudio_setup(audio_des);
 
 	assert(sns::SampleRate == saudio_sample_rate());
@@ -0,0 +1,245 @@
+#include "../engine/instrument/drummachine/DrumFont.hpp"
+
+#include "tsf/tsf.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+using namespace sns;
+
+//
+// The native drum voices against TinySoundFont rendering the same font: a fixed hit sequence
+// through both has to give the same output
+//
+
+static void put16(std::vector<uint8_t>& output, uint16_t value) {
+	output.insert(output.end(), { uint8_t(value), uint8_t(value >> 8) });
+}
+
+static void put32(std::vector<uint8_t>& output, uint32_t value) {
+	put16(output, uint16_t(value));
+	put16(output, uint16_t(value >> 16));
+}
+
+static void putName(std::vector<uint8_t>& output, char const* name) {
+	char padded[20] = {};
+	strncpy(padded, name, sizeof(padded) - 1);
+	output.insert(output.end(), padded, padded + sizeof(padded));
+}
+
+static std::vector<uint8_t> chunk(char const* id, std::vector<uint8_t> const& data) {
+	std::vector<uint8_t> output(id, id + 4);
+	put32(output, uint32_t(data.size()));
+	output.insert(output.end(), data.begin(), data.end());
+	if (data.size() % 2)
+		output.push_back(0);
+	return output;
+}
+
+static std::vector<uint8_t> list(char const* id, std::vector<std::vector<uint8_t>> const& chunks) {
+	std::vector<uint8_t> data(id, id + 4);
+	for (auto const& current : chunks)
+		data.insert(data.end(), current.begin(), current.end());
+	return chunk("LIST", data);
+}
+
+//
+// A kit: a plain hit, a half rate sample tracking the keys in an exclusive class,
+// a hihat with a decay, and a filtered, attenuated hit.
+// As a general midi font the kit is in bank 128 after a melodic program
+//
+static std::vector<uint8_t> buildKit(bool general_midi) {
+	struct Zone {
+		int lokey;
+		int hikey;
+		int sample;
+		std::vector<std::pair<uint16_t, uint16_t>> generators;
+	};
+
+	const int frames = 3000;
+	const int padding = 46; // zeros after every sample, as the format asks for
+	const int rates[] = { 44100, 22050, 44100 };
+
+	std::vector<uint8_t> smpl;
+	std::vector<uint8_t> shdr;
+	for (int s = 0; s != 3; ++s) {
+		const uint32_t start = uint32_t(s * (frames + padding));
+		for (int i = 0; i != frames; ++i)
+			put16(smpl, uint16_t(int16_t(12000.0 * sin(i * 0.05 * (s + 1)) * exp(-i / 900.0))));
+		for (int i = 0; i != padding; ++i)
+			put16(smpl, 0);
+
+		putName(shdr, "sample");
+		put32(shdr, start);
+		put32(shdr, start + frames);
+		put32(shdr, start);
+		put32(shdr, start + frames);
+		put32(shdr, uint32_t(rates[s]));
+		shdr.insert(shdr.end(), { 60, 0 });
+		put16(shdr, 0);
+		put16(shdr, 1);
+	}
+	putName(shdr, "EOS");
+	shdr.insert(shdr.end(), 46 - 20, 0);
+
+	const std::vector<Zone> zones = {
+		{ 36, 36, 0, {} },
+		{ 38, 40, 1, { { 57, 1 } } },								// exclusive class
+		{ 42, 42, 2, { { 36, uint16_t(int16_t(-2000)) }, { 57, 1 } } },	// decay, exclusive class
+		{ 45, 46, 0, { { 8, 6000 }, { 9, 100 }, { 48, 60 } } },		// filter cutoff and resonance, attenuation
+	};
+
+	std::vector<uint8_t> ibag;
+	std::vector<uint8_t> igen;
+	uint16_t generators = 0;
+	for (auto const& zone : zones) {
+		put16(ibag, generators);
+		put16(ibag, 0);
+
+		put16(igen, 43);
+		igen.insert(igen.end(), { uint8_t(zone.lokey), uint8_t(zone.hikey) });
+		for (auto const& [op, amount] : zone.generators) {
+			put16(igen, op);
+			put16(igen, amount);
+		}
+		put16(igen, 53);
+		put16(igen, uint16_t(zone.sample));
+		generators += uint16_t(zone.generators.size() + 2);
+	}
+	put16(ibag, generators);
+	put16(ibag, 0);
+	put32(igen, 0);
+
+	// presets, bags and generators, the melodic program plays the same zones an octave up
+	struct Preset {
+		char const* name;
+		uint16_t bank;
+		std::vector<std::pair<uint16_t, uint16_t>> generators;
+	};
+	std::vector<Preset> presets;
+	if (general_midi)
+		presets.push_back({ "piano", 0, { { 51, 12 } } });
+	presets.push_back({ "kit", uint16_t(general_midi ? 128 : 0), {} });
+
+	std::vector<uint8_t> phdr;
+	std::vector<uint8_t> pbag;
+	std::vector<uint8_t> pgen;
+	uint16_t preset_generators = 0;
+	for (size_t p = 0; p != presets.size(); ++p) {
+		putName(phdr, presets[p].name);
+		put16(phdr, 0); put16(phdr, presets[p].bank); put16(phdr, uint16_t(p));
+		put32(phdr, 0); put32(phdr, 0); put32(phdr, 0);
+
+		put16(pbag, preset_generators); put16(pbag, 0);
+		for (auto const& [op, amount] : presets[p].generators) {
+			put16(pgen, op);
+			put16(pgen, amount);
+		}
+		put16(pgen, 41); put16(pgen, 0); // instrument 0
+		preset_generators += uint16_t(presets[p].generators.size() + 1);
+	}
+	putName(phdr, "EOP");
+	put16(phdr, 0); put16(phdr, 0); put16(phdr, uint16_t(presets.size()));
+	put32(phdr, 0); put32(phdr, 0); put32(phdr, 0);
+	put16(pbag, preset_generators); put16(pbag, 0);
+	put32(pgen, 0);
+
+	std::vector<uint8_t> inst;
+	putName(inst, "kit");
+	put16(inst, 0);
+	putName(inst, "EOI");
+	put16(inst, uint16_t(zones.size()));
+
+	const std::vector<uint8_t> modulators(10, 0);
+
+	std::vector<uint8_t> body = { 's', 'f', 'b', 'k' };
+	for (auto const& current : {
+		list("INFO", { chunk("ifil", { 2, 0, 1, 0 }) }),
+		list("sdta", { chunk("smpl", smpl) }),
+		list("pdta", { chunk("phdr", phdr), chunk("pbag", pbag), chunk("pmod", modulators), chunk("pgen", pgen),
+			chunk("inst", inst), chunk("ibag", ibag), chunk("imod", modulators), chunk("igen", igen), chunk("shdr", shdr) }) })
+		body.insert(body.end(), current.begin(), current.end());
+
+	return chunk("RIFF", body);
+}
+
+static bool compare(char const* name, bool general_midi, int kit_preset) {
+	const std::vector<uint8_t> kit = buildKit(general_midi);
+
+	auto native = DrumFont::fromMemory(kit.data(), kit.size());
+	tsf* reference = tsf_load_memory(kit.data(), int(kit.size()));
+
+	if (!native || !reference) {
+		printf("FAIL the %s does not load\n", name);
+		return false;
+	}
+
+	if (native->voices.empty()) {
+		printf("FAIL the %s is not played by the native voices\n", name);
+		return false;
+	}
+
+	if (native->preset != kit_preset) {
+		printf("FAIL the %s plays preset %d instead of %d\n", name, native->preset, kit_preset);
+		return false;
+	}
+
+	tsf_set_output(reference, TSF_MONO, int(SampleRate), 0);
+
+	struct Hit {
+		int block;
+		int key;
+		float velocity; // 0 releases
+	};
+
+	// overlapping hits, chokes, releases and velocities, every key range of the kit
+	const std::vector<Hit> hits = {
+		{ 0, 36, 0.8f }, { 6, 42, 1.0f }, { 10, 36, 0.0f }, { 12, 38, 0.5f }, { 14, 40, 0.9f },
+		{ 20, 42, 0.3f }, { 21, 42, 0.0f }, { 25, 45, 1.0f }, { 26, 46, 0.6f }, { 30, 39, 0.7f },
+		{ 40, 45, 0.0f }, { 44, 36, 0.2f }, { 46, 36, 1.0f }, { 60, 38, 0.0f },
+	};
+
+	const int blocks = 120;
+	std::vector<float> expected(DrumVoices::Block);
+	std::vector<float> produced(DrumVoices::Block);
+
+	float error = 0.0f;
+	float peak = 0.0f;
+	size_t next = 0;
+
+	for (int block = 0; block != blocks; ++block) {
+		for (; next != hits.size() && hits[next].block == block; ++next) {
+			Hit const& hit = hits[next];
+			if (hit.velocity > 0.0f) {
+				native->voices.noteOn(hit.key, hit.velocity);
+				tsf_note_on(reference, kit_preset, hit.key, hit.velocity);
+			}
+			else {
+				native->voices.noteOff(hit.key);
+				tsf_note_off(reference, kit_preset, hit.key);
+			}
+		}
+
+		native->voices.render(produced.data(), DrumVoices::Block);
+		tsf_render_float(reference, expected.data(), DrumVoices::Block, 0);
+
+		for (int i = 0; i != DrumVoices::Block; ++i) {
+			error = std::max(error, std::fabs(produced[i] - expected[i]));
+			peak = std::max(peak, std::fabs(expected[i]));
+		}
+	}
+
+	tsf_close(reference);
+
+	const float tolerance = 1e-4f;
+	const bool ok = (error <= tolerance && peak > 0.1f);
+	printf("%s %s peak %g, largest difference %g (tolerance %g)\n", ok ? "OK" : "FAIL", name, peak, error, tolerance);
+	return ok;
+}
+
+int main() {
+	bool ok = compare("drum kit", false, 0);
+	ok = compare("general midi font", true, 1) && ok;
+	return ok ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,117 @@
+#include "../engine/instrument/tb303/rosic_MidiNoteStack.h"
+
+#include <cstdio>
+
+using namespace rosic;
+
+//
+// The fixed capacity note stack of the TB303 has to keep the behaviour of the std::list it replaced:
+// last note priority, removing a key removes all its entries, and the oldest note goes when it is full
+//
+
+static int failures = 0;
+
+static void check(bool condition, char const* what) {
+	if (!condition) {
+		printf("FAIL %s\n", what);
+		failures++;
+	}
+}
+
+static void testPush() {
+	MidiNoteStack stack;
+	check(stack.empty() && stack.size() == 0, "a new stack is empty");
+
+	stack.push_front(MidiNoteEvent(60, 100));
+	stack.push_front(MidiNoteEvent(64, 90));
+	stack.push_front(MidiNoteEvent(67, 80));
+
+	check(!stack.empty() && stack.size() == 3, "push adds a note");
+	check(stack.front().getKey() == 67 && stack.front().getVelocity() == 80, "the last pushed note is on top");
+
+	stack.clear();
+	check(stack.empty(), "clear forgets every note");
+}
+
+static void testRemove() {
+	MidiNoteStack stack;
+	stack.push_front(MidiNoteEvent(60, 100));
+	stack.push_front(MidiNoteEvent(64, 90));
+	stack.push_front(MidiNoteEvent(67, 80));
+
+	// releasing the top note falls back to the previous one
+	stack.remove(MidiNoteEvent(67, 0));
+	check(stack.size() == 2 && stack.front().getKey() == 64, "removing the top note uncovers the previous one");
+
+	// releasing a note below the top keeps the top
+	stack.remove(MidiNoteEvent(60, 0));
+	check(stack.size() == 1 && stack.front().getKey() == 64, "removing a held note below keeps the top");
+
+	// releasing a key that is not held changes nothing
+	stack.remove(MidiNoteEvent(72, 0));
+	check(stack.size() == 1 && stack.front().getKey() == 64, "removing a key that is not held is ignored");
+
+	stack.remove(MidiNoteEvent(64, 0));
+	check(stack.empty(), "removing the last note empties the stack");
+}
+
+static void testDuplicates() {
+	MidiNoteStack stack;
+	stack.push_front(MidiNoteEvent(60, 100));
+	stack.push_front(MidiNoteEvent(64, 90));
+	stack.push_front(MidiNoteEvent(60, 70));
+	stack.push_front(MidiNoteEvent(67, 80));
+	stack.push_front(MidiNoteEvent(60, 50));
+
+	check(stack.size() == 5 && stack.front().getKey() == 60 && stack.front().getVelocity() == 50, "a key pushed again is kept as a new entry");
+
+	// every entry of the key goes, in one remove
+	stack.remove(MidiNoteEvent(60, 0));
+	check(stack.size() == 2, "removing a key removes all its entries");
+	check(stack.front().getKey() == 67, "the order of the other notes is kept");
+
+	stack.remove(MidiNoteEvent(67, 0));
+	check(stack.size() == 1 && stack.front().getKey() == 64, "the oldest of the other notes is left");
+}
+
+static void testOverflow() {
+	MidiNoteStack stack;
+
+	// more notes than it can hold, the oldest are forgotten
+	const int extra = 5;
+	for (int i = 0; i != MidiNoteStack::capacity + extra; ++i)
+		stack.push_front(MidiNoteEvent(i % 128, 1 + i % 127));
+
+	check(stack.size() == MidiNoteStack::capacity, "a full stack stays at its capacity");
+
+	const int last = MidiNoteStack::capacity + extra - 1;
+	check(stack.front().getKey() == last % 128 && stack.front().getVelocity() == 1 + last % 127, "the newest note is on top of a full stack");
+
+	// keys 0..extra-1 were pushed twice, the first time is forgotten and the second one is still held
+	stack.remove(MidiNoteEvent(0, 0));
+	check(stack.size() == MidiNoteStack::capacity - 1, "an overflowed key is held once");
+
+	// unwinding the stack goes from the newest to the oldest still held
+	int expected = last;
+	bool ordered = true;
+	while (!stack.empty()) {
+		if (expected % 128 == 0)
+			expected--;
+
+		ordered = ordered && (stack.front().getKey() == expected % 128);
+		stack.remove(stack.front());
+		expected--;
+	}
+	check(ordered, "the notes unwind newest first");
+	check(expected == extra - 1, "the oldest notes were dropped on overflow");
+}
+
+int main() {
+	testPush();
+	testRemove();
+	testDuplicates();
+	testOverflow();
+
+	printf("%s %d failures\n", failures ? "FAIL" : "OK", failures);
+	return failures ? 1 : 0;
+}
\ No newline at end of file